@@ -0,0 +1,70 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include "../hpc/dataflow.h"
+
+// Runs the generate -> sort -> reduce job staged and streamed on the same
+// data, checks that both reach the same statistics, and prints where the
+// streamed pipeline spends its time.
+
+void print_result(const std::string& label, const DataflowResult& r, double bytes, long long chunkBytes) {
+    std::cout << std::left << std::setw(10) << label << std::right << std::fixed << std::setprecision(3)
+              << std::setw(12) << r.seconds * 1e3 << " ms" << std::setprecision(1) << std::setw(10)
+              << bytes / 1e6 / r.seconds << " MB/s" << std::setw(10) << r.peakChunks * chunkBytes / 1e6
+              << " MB peak" << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    DataflowConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--chunks" && has_value) {
+            cfg.chunks = std::max(1LL, std::atoll(argv[++i]));
+        } else if (arg == "--chunk-size" && has_value) {
+            cfg.chunkSize = std::max(1LL, std::atoll(argv[++i]));
+        } else if (arg == "--sort-threads" && has_value) {
+            cfg.sortThreads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--capacity" && has_value) {
+            cfg.capacity = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cout << "Usage: dataflow_bench [--chunks n] [--chunk-size n] [--sort-threads t] [--capacity c]\n";
+            return 1;
+        }
+    }
+
+    DataflowJob job(cfg);
+    long long chunkBytes = cfg.chunkSize * static_cast<long long>(sizeof(int));
+    std::cout << cfg.chunks << " chunks of " << cfg.chunkSize << " ints (" << job.datasetBytes() / 1e6 << " MB), "
+              << cfg.sortThreads << " sort threads, channel capacity " << cfg.capacity << "\n\n";
+
+    DataflowResult staged = job.runStaged();
+    std::cout << "Staged, one stage after another:\n";
+    for (const auto& stage : staged.stageSeconds) {
+        std::cout << "  " << std::left << std::setw(10) << stage.first << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(10) << stage.second * 1e3 << " ms\n";
+    }
+
+    std::cout << "\nStreamed, all stages at once:\n";
+    DataflowResult streamed = job.runStreamed(&std::cout);
+
+    std::cout << "\n";
+    print_result("Staged", staged, job.datasetBytes(), chunkBytes);
+    print_result("Streamed", streamed, job.datasetBytes(), chunkBytes);
+    double slowest = 0.0;
+    for (const auto& stage : staged.stageSeconds) slowest = std::max(slowest, stage.second);
+    std::cout << "Speedup " << std::setprecision(2) << staged.seconds / streamed.seconds << "x; the slowest stage alone takes "
+              << std::setprecision(3) << slowest * 1e3 << " ms\n";
+
+    bool ok = staged.sameStatistics(streamed) && streamed.sortedRuns == cfg.chunks && staged.sortedRuns == cfg.chunks;
+    std::cout << "Count " << streamed.count << ", min " << streamed.min << ", max " << streamed.max << ", average "
+              << std::setprecision(4) << streamed.average() << " -- " << (ok ? "Verified" : "MISMATCH") << std::endl;
+    return ok ? 0 : 1;
+}
+
+/*
+Command -> g++ -O2 -pthread dataflow_bench.cpp ../hpc/dataflow.cpp -o dataflow_bench && ./dataflow_bench
+CMake   -> cmake -S .. -B ../build && cmake --build ../build --target dataflow_bench
+*/
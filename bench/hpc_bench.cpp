@@ -0,0 +1,701 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <cstdlib>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <omp.h>
+#ifdef HPC_WITH_MPI
+#include <mpi.h>
+#endif
+#include "../common/perf_regions.h"
+#include "../common/work_stealing.h"
+#include "../hpc/dataflow.h"
+#include "../hpc/dynamic_graph.h"
+#include "../hpc/graph.h"
+#include "../hpc/reduction.h"
+#include "../hpc/sorting.h"
+#ifdef HPC_WITH_MPI
+#include "../hpc/sample_sort.h"
+#endif
+#include "json.h"
+
+// One benchmark driver for every kernel of the library. A kernel is
+// instantiated per (size, thread count); each instance is reset before
+// every run so that all runs see the same input, timed over the warmup
+// and measured repetitions, and checked once after the last run.
+
+struct BenchConfig {
+    std::vector<std::string> kernels = {"*"};
+    std::vector<long long> sizes;  // empty: each kernel's defaults
+    std::vector<int> threads;      // empty: the OpenMP default
+    int repeat = 5;
+    int warmup = 1;
+    bool pin = false;
+    bool list = false;
+    std::string json_path;
+    std::string baseline_path;
+    double threshold = 0.05;       // relative slowdown tolerated beyond the measured noise
+};
+
+struct Instance {
+    std::function<void()> reset = [] {};
+    std::function<void()> run;
+    std::function<bool()> check = [] { return true; };
+    double ops = 0.0;   // declared work, for the perf regions
+    double bytes = 0.0;
+};
+
+class BenchContext;
+
+struct Kernel {
+    std::string name;
+    std::vector<long long> sizes;
+    bool threaded;    // sequential kernels run once, at one thread
+    bool collective;  // every MPI rank takes part; the rest run on rank 0 only
+    std::function<Instance(BenchContext&, long long size, int threads)> make;
+};
+
+struct Result {
+    std::string kernel;
+    long long size;
+    int threads;
+    int ranks;
+    std::vector<double> samples;  // ms
+    double min, median, mean, stddev, cv;
+    bool verified;
+};
+
+// Inputs are cached for the size last asked for, and only one thread pool
+// exists at a time: a Scheduler binds the thread that constructs it, so a
+// second live one would take the driver thread away from the first.
+class BenchContext {
+private:
+    std::unique_ptr<ws::Scheduler> pool;
+    std::unique_ptr<SortingBenchmark> sorting;
+    int poolThreads = 0;
+    int sortingThreads = 0;
+
+    std::unique_ptr<Graph> cachedGraph;
+    std::unique_ptr<DynamicGraph> cachedStream;
+    std::vector<DynamicGraph::Edge> streamEdges;
+    std::mt19937_64 streamGen;
+    long long graphReach = 0;
+    std::unique_ptr<ParallelReduction> cachedReduction;
+    long long reductionSize = -1;
+    std::vector<int> cachedArray;
+
+public:
+    bool pin = false;
+    int rank = 0;
+    int ranks = 1;
+
+    ws::Scheduler& scheduler(int threads) {
+        if (!pool || poolThreads != threads) {
+            sorting.reset();
+            pool.reset();
+            pool.reset(new ws::Scheduler(threads, pin));
+            poolThreads = threads;
+        }
+        return *pool;
+    }
+
+    SortingBenchmark& sorter(int threads) {
+        if (!sorting || sortingThreads != threads) {
+            pool.reset();
+            sorting.reset();
+            sorting.reset(new SortingBenchmark(std::vector<int>(), 1, threads, pin));
+            sortingThreads = threads;
+        }
+        return *sorting;
+    }
+
+    // Two random edges per vertex, so that vertex 0 almost surely sits in
+    // the giant component and a traversal covers most of the graph; the
+    // sequential BFS reach is what every traversal must match.
+    Graph& graph(long long vertices, long long& reach) {
+        if (!cachedGraph || cachedGraph->size() != vertices) {
+            cachedGraph.reset();
+            cachedGraph.reset(new Graph(Graph::random(vertices, 2 * vertices, 12345)));
+            graphReach = cachedGraph->sequentialBFS(0);
+        }
+        reach = graphReach;
+        return *cachedGraph;
+    }
+
+    // The streaming graph keeps changing across runs; its edge list is
+    // kept so that a batch can delete edges that exist.
+    DynamicGraph& stream(long long vertices, int threads, std::vector<DynamicGraph::Edge>*& edges,
+                         std::mt19937_64*& gen) {
+        if (!cachedStream || cachedStream->size() != vertices) {
+            cachedStream.reset();
+            cachedStream.reset(new DynamicGraph(vertices, std::vector<long long>(1, 0)));
+            streamGen.seed(12345);
+            std::uniform_int_distribution<long long> vertex(0, vertices - 1);
+            streamEdges.resize(2 * vertices);
+            for (DynamicGraph::Edge& e : streamEdges) e = {vertex(streamGen), vertex(streamGen)};
+            cachedStream->applyBatch(scheduler(threads), streamEdges, std::vector<DynamicGraph::Edge>());
+        }
+        edges = &streamEdges;
+        gen = &streamGen;
+        return *cachedStream;
+    }
+
+    ParallelReduction& reduction(long long size) {
+        if (!cachedReduction || reductionSize != size) {
+            cachedReduction.reset();
+            cachedReduction.reset(new ParallelReduction(static_cast<int>(size), -10000, 10000));
+            reductionSize = size;
+        }
+        return *cachedReduction;
+    }
+
+    const std::vector<int>& array(long long size) {
+        if (cachedArray.size() != static_cast<size_t>(size)) {
+            cachedArray.resize(size);
+            std::mt19937 gen(12345);
+            std::uniform_int_distribution<int> value(1, static_cast<int>(std::min(size * 10, 2000000000LL)));
+            for (int& v : cachedArray) v = value(gen);
+        }
+        return cachedArray;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Kernels
+
+// A pooled traversal gets the work-stealing pool, built when the instance
+// is made rather than in the timed run; the others get a null pool.
+Kernel traversal_kernel(const std::string& name, bool threaded, bool pooled,
+                        std::function<long long(Graph&, ws::Scheduler*)> traverse) {
+    Kernel k;
+    k.name = name;
+    k.sizes = {100000, 1000000};
+    k.threaded = threaded;
+    k.collective = false;
+    k.make = [pooled, traverse](BenchContext& ctx, long long size, int threads) {
+        Instance in;
+        long long expected;
+        Graph& g = ctx.graph(size, expected);
+        ws::Scheduler* pool = pooled ? &ctx.scheduler(threads) : nullptr;
+        std::shared_ptr<long long> reached(new long long(0));
+        in.run = [&g, pool, traverse, reached] { *reached = traverse(g, pool); };
+        in.check = [expected, reached] { return *reached == expected; };
+        in.ops = g.traversalOps();
+        in.bytes = g.traversalBytes();
+        return in;
+    };
+    return k;
+}
+
+Kernel sort_kernel(const std::string& name, bool threaded, std::vector<long long> sizes, bool quadratic,
+                   std::function<void(SortingBenchmark&, std::vector<int>&)> sort) {
+    Kernel k;
+    k.name = name;
+    k.sizes = sizes;
+    k.threaded = threaded;
+    k.collective = false;
+    k.make = [sort, quadratic](BenchContext& ctx, long long size, int threads) {
+        Instance in;
+        SortingBenchmark& sorter = ctx.sorter(threads);
+        const std::vector<int>& input = ctx.array(size);
+        std::shared_ptr<std::vector<int>> work(new std::vector<int>());
+        in.reset = [work, &input] { *work = input; };
+        in.run = [&sorter, sort, work] { sort(sorter, *work); };
+        in.check = [work] { return std::is_sorted(work->begin(), work->end()); };
+        // Same declared work as two.cpp.
+        double n = size;
+        in.ops = quadratic ? n * n / 2 : n * std::log2(n);
+        in.bytes = quadratic ? n * n * sizeof(int) : 4 * in.ops * sizeof(int);
+        return in;
+    };
+    return k;
+}
+
+// Every run applies a fresh batch of size / 1000 insertions and as many
+// deletions of existing edges: bfs.incremental times the batch with its
+// repair, bfs.recompute applies it untimed and times the BFS from scratch
+// that a static graph would need instead.
+Kernel stream_kernel(const std::string& name, bool incremental) {
+    Kernel k;
+    k.name = name;
+    k.sizes = {100000, 1000000};
+    k.threaded = true;
+    k.collective = false;
+    k.make = [incremental](BenchContext& ctx, long long size, int threads) {
+        Instance in;
+        std::vector<DynamicGraph::Edge>* edges;
+        std::mt19937_64* gen;
+        DynamicGraph& g = ctx.stream(size, threads, edges, gen);
+        ws::Scheduler& pool = ctx.scheduler(threads);
+        typedef std::vector<DynamicGraph::Edge> Batch;
+        std::shared_ptr<Batch> insertions(new Batch()), deletions(new Batch());
+        in.reset = [&g, &pool, edges, gen, size, incremental, insertions, deletions] {
+            long long batch = std::max(1LL, size / 1000);
+            std::uniform_int_distribution<long long> vertex(0, size - 1);
+            insertions->clear();
+            deletions->clear();
+            for (long long i = 0; i < batch; i++) {
+                insertions->push_back({vertex(*gen), vertex(*gen)});
+                size_t victim = (*gen)() % edges->size();
+                deletions->push_back((*edges)[victim]);
+                (*edges)[victim] = edges->back();
+                edges->pop_back();
+            }
+            edges->insert(edges->end(), insertions->begin(), insertions->end());
+            if (!incremental) g.applyBatch(pool, *insertions, *deletions);
+        };
+        if (incremental) {
+            in.run = [&g, &pool, insertions, deletions] { g.applyBatch(pool, *insertions, *deletions); };
+        } else {
+            in.run = [&g, &pool] { g.recompute(pool); };
+        }
+        in.check = [&g] { return g.verify(); };
+        return in;
+    };
+    return k;
+}
+
+// The generate -> sort -> reduce job over size integers in 64K-element
+// chunks, with threads sorting; dataflow_bench breaks the streamed run
+// down per stage.
+Kernel dataflow_kernel(const std::string& name, bool streamed) {
+    Kernel k;
+    k.name = name;
+    k.sizes = {1 << 22, 1 << 24};
+    k.threaded = true;
+    k.collective = false;
+    k.make = [streamed](BenchContext&, long long size, int threads) {
+        Instance in;
+        DataflowConfig cfg;
+        cfg.chunks = std::max(1LL, size / cfg.chunkSize);
+        cfg.sortThreads = threads;
+        std::shared_ptr<DataflowJob> job(new DataflowJob(cfg));
+        std::shared_ptr<DataflowResult> result(new DataflowResult());
+        in.run = [job, result, streamed] { *result = streamed ? job->runStreamed() : job->runStaged(); };
+        // A fresh staged run is the reference: the same chunks reduced one
+        // stage after another must give the same statistics.
+        in.check = [job, result, cfg] {
+            DataflowResult reference = job->runStaged();
+            return result->sameStatistics(reference) && result->count == cfg.chunks * cfg.chunkSize &&
+                   result->sortedRuns == cfg.chunks;
+        };
+        in.bytes = job->datasetBytes();
+        return in;
+    };
+    return k;
+}
+
+template<typename R>
+Kernel reduction_kernel(const std::string& name, bool threaded, R (ParallelReduction::*op)(),
+                        R (ParallelReduction::*reference)()) {
+    Kernel k;
+    k.name = name;
+    k.sizes = {10000000};
+    k.threaded = threaded;
+    k.collective = false;
+    k.make = [op, reference](BenchContext& ctx, long long size, int) {
+        Instance in;
+        ParallelReduction& reduction = ctx.reduction(size);
+        std::shared_ptr<R> result(new R());
+        in.run = [&reduction, op, result] { *result = (reduction.*op)(); };
+        in.check = [&reduction, reference, result] { return *result == (reduction.*reference)(); };
+        in.ops = static_cast<double>(size);
+        in.bytes = static_cast<double>(size) * sizeof(int);
+        return in;
+    };
+    return k;
+}
+
+std::vector<Kernel> all_kernels() {
+    std::vector<Kernel> kernels;
+    kernels.push_back(traversal_kernel("bfs.seq", false, false, [](Graph& g, ws::Scheduler*) { return g.sequentialBFS(0); }));
+    kernels.push_back(traversal_kernel("bfs.omp", true, false, [](Graph& g, ws::Scheduler*) { return g.parallelBFS(0); }));
+    kernels.push_back(traversal_kernel("bfs.ws", true, true, [](Graph& g, ws::Scheduler* pool) {
+        return g.workStealingBFS(*pool, 0);
+    }));
+    kernels.push_back(traversal_kernel("dfs.seq", false, false, [](Graph& g, ws::Scheduler*) { return g.sequentialDFS(0); }));
+    kernels.push_back(traversal_kernel("dfs.omp", true, false, [](Graph& g, ws::Scheduler*) { return g.parallelDFS(0); }));
+    kernels.push_back(traversal_kernel("dfs.ws", true, true, [](Graph& g, ws::Scheduler* pool) {
+        return g.workStealingDFS(*pool, 0);
+    }));
+    kernels.push_back(stream_kernel("bfs.incremental", true));
+    kernels.push_back(stream_kernel("bfs.recompute", false));
+
+    const std::vector<long long> bubbleSizes = {2000, 10000};
+    const std::vector<long long> mergeSizes = {100000, 1000000};
+    kernels.push_back(sort_kernel("bubble.seq", false, bubbleSizes, true,
+                                  [](SortingBenchmark& s, std::vector<int>& a) { s.sequentialBubbleSort(a); }));
+    kernels.push_back(sort_kernel("bubble.omp", true, bubbleSizes, true,
+                                  [](SortingBenchmark& s, std::vector<int>& a) { s.parallelBubbleSort(a); }));
+    kernels.push_back(sort_kernel("bubble.ws", true, bubbleSizes, true,
+                                  [](SortingBenchmark& s, std::vector<int>& a) { s.workStealingBubbleSort(a); }));
+    kernels.push_back(sort_kernel("merge.seq", false, mergeSizes, false,
+                                  [](SortingBenchmark& s, std::vector<int>& a) { s.sequentialMergeSort(a); }));
+    kernels.push_back(sort_kernel("merge.omp", true, mergeSizes, false,
+                                  [](SortingBenchmark& s, std::vector<int>& a) { s.parallelMergeSort(a); }));
+    kernels.push_back(sort_kernel("merge.ws", true, mergeSizes, false,
+                                  [](SortingBenchmark& s, std::vector<int>& a) { s.workStealingMergeSort(a); }));
+
+    kernels.push_back(reduction_kernel("min.seq", false, &ParallelReduction::sequentialMin, &ParallelReduction::sequentialMin));
+    kernels.push_back(reduction_kernel("min.omp", true, &ParallelReduction::parallelMin, &ParallelReduction::sequentialMin));
+    kernels.push_back(reduction_kernel("max.seq", false, &ParallelReduction::sequentialMax, &ParallelReduction::sequentialMax));
+    kernels.push_back(reduction_kernel("max.omp", true, &ParallelReduction::parallelMax, &ParallelReduction::sequentialMax));
+    kernels.push_back(reduction_kernel("sum.seq", false, &ParallelReduction::sequentialSum, &ParallelReduction::sequentialSum));
+    kernels.push_back(reduction_kernel("sum.omp", true, &ParallelReduction::parallelSum, &ParallelReduction::sequentialSum));
+    kernels.push_back(reduction_kernel("avg.seq", false, &ParallelReduction::sequentialAverage, &ParallelReduction::sequentialAverage));
+    kernels.push_back(reduction_kernel("avg.omp", true, &ParallelReduction::parallelAverage, &ParallelReduction::sequentialAverage));
+
+    kernels.push_back(dataflow_kernel("dataflow.staged", false));
+    kernels.push_back(dataflow_kernel("dataflow.streamed", true));
+
+#ifdef HPC_WITH_MPI
+    Kernel sample;
+    sample.name = "sample_sort";
+    sample.sizes = {1000000, 10000000};
+    sample.threaded = true;
+    sample.collective = true;
+    sample.make = [](BenchContext& ctx, long long size, int) {
+        Instance in;
+        std::shared_ptr<std::vector<int>> input(new std::vector<int>(generate_local_block<int>(size, "uniform", MPI_COMM_WORLD)));
+        uint64_t checksum = distributed_checksum(*input, MPI_COMM_WORLD);
+        std::shared_ptr<std::vector<int>> work(new std::vector<int>());
+        std::shared_ptr<std::vector<int>> sorted(new std::vector<int>());
+        in.reset = [input, work] { *work = *input; };
+        in.run = [work, sorted] { *sorted = parallel_sample_sort(*work, SortOptions(), MPI_COMM_WORLD); };
+        in.check = [sorted, size, checksum] { return verify_distributed_sorted(*sorted, size, checksum, MPI_COMM_WORLD); };
+        in.ops = size * std::log2(static_cast<double>(size)) / ctx.ranks;
+        in.bytes = data_bytes(*input);
+        return in;
+    };
+    kernels.push_back(sample);
+#endif
+    return kernels;
+}
+
+// ---------------------------------------------------------------------------
+// Running
+
+// OpenMP team size, and with --pin one allowed CPU per thread (offset by
+// rank, so that ranks on one node do not share CPUs).
+void apply_threads(int threads, const BenchContext& ctx) {
+    omp_set_num_threads(threads);
+    if (!ctx.pin) return;
+    #pragma omp parallel
+    {
+        ws::pinCurrentThread(ctx.rank * threads + omp_get_thread_num());
+    }
+}
+
+void barrier(const Kernel& kernel) {
+#ifdef HPC_WITH_MPI
+    if (kernel.collective) MPI_Barrier(MPI_COMM_WORLD);
+#else
+    (void)kernel;
+#endif
+}
+
+void summarize(Result& r) {
+    std::vector<double> sorted = r.samples;
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    r.min = sorted.front();
+    r.median = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    double sum = 0.0;
+    for (double t : sorted) sum += t;
+    r.mean = sum / n;
+    double squares = 0.0;
+    for (double t : sorted) squares += (t - r.mean) * (t - r.mean);
+    r.stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0.0;
+    r.cv = r.mean > 0 ? r.stddev / r.mean : 0.0;
+}
+
+Result run_kernel(const Kernel& kernel, long long size, int threads, const BenchConfig& cfg, BenchContext& ctx) {
+    apply_threads(threads, ctx);
+    Instance in = kernel.make(ctx, size, threads);
+    std::string region = kernel.name + " " + std::to_string(size) + " x" + std::to_string(threads);
+
+    Result r;
+    r.kernel = kernel.name;
+    r.size = size;
+    r.threads = threads;
+    r.ranks = kernel.collective ? ctx.ranks : 1;
+    for (int i = 0; i < cfg.warmup + cfg.repeat; i++) {
+        in.reset();
+        barrier(kernel);
+        if (i < cfg.warmup) {
+            in.run();
+            barrier(kernel);
+            continue;
+        }
+        std::chrono::high_resolution_clock::time_point start, end;
+        {
+            perf::Region counted(region, in.ops, in.bytes);
+            start = std::chrono::high_resolution_clock::now();
+            in.run();
+            barrier(kernel);
+            end = std::chrono::high_resolution_clock::now();
+        }
+        r.samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    r.verified = in.check();
+    summarize(r);
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// JSON and baseline comparison
+
+std::string timestamp() {
+    std::time_t now = std::time(nullptr);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buf;
+}
+
+std::string hostname() {
+    char buf[256] = {0};
+    if (gethostname(buf, sizeof(buf) - 1) != 0) return "unknown";
+    return buf;
+}
+
+void write_json(const std::string& path, const std::vector<Result>& results, const BenchConfig& cfg) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return;
+    }
+    out << std::setprecision(6);
+    out << "{\n  \"meta\": {\"host\": " << json::quote(hostname()) << ", \"compiler\": " << json::quote(__VERSION__)
+        << ", \"timestamp\": " << json::quote(timestamp()) << ", \"repeat\": " << cfg.repeat
+        << ", \"warmup\": " << cfg.warmup << ", \"pinned\": " << (cfg.pin ? "true" : "false") << "},\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        out << "    {\"kernel\": " << json::quote(r.kernel) << ", \"size\": " << r.size << ", \"threads\": " << r.threads
+            << ", \"ranks\": " << r.ranks << ", \"median_ms\": " << r.median << ", \"min_ms\": " << r.min
+            << ", \"mean_ms\": " << r.mean << ", \"stddev_ms\": " << r.stddev << ", \"cv\": " << r.cv
+            << ", \"verified\": " << (r.verified ? "true" : "false") << ", \"samples_ms\": [";
+        for (size_t s = 0; s < r.samples.size(); s++) out << (s ? ", " : "") << r.samples[s];
+        out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+std::string result_key(const std::string& kernel, long long size, int threads, int ranks) {
+    return kernel + "/" + std::to_string(size) + "/" + std::to_string(threads) + "/" + std::to_string(ranks);
+}
+
+// A result is a slowdown when its median exceeds the baseline median by
+// more than the threshold plus twice the combined relative noise of the
+// two runs, so noisy kernels need a larger change before they are flagged.
+// Returns the number of slowdowns.
+int compare_with_baseline(const std::string& path, const std::vector<Result>& results, double threshold) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot read baseline " << path << std::endl;
+        return 0;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    json::Value baseline;
+    try {
+        baseline = json::parse(text.str());
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid baseline " << path << ": " << e.what() << std::endl;
+        return 0;
+    }
+
+    std::map<std::string, const json::Value*> byKey;
+    if (baseline.has("results")) {
+        for (const json::Value& r : baseline["results"].items) {
+            byKey[result_key(r["kernel"].text, static_cast<long long>(r["size"].number),
+                             static_cast<int>(r["threads"].number), static_cast<int>(r["ranks"].number))] = &r;
+        }
+    }
+
+    std::cout << "\nBaseline: " << path;
+    if (baseline.has("meta") && baseline["meta"].has("timestamp")) std::cout << " (" << baseline["meta"]["timestamp"].text << ")";
+    std::cout << "\n";
+    std::cout << std::left << std::setw(18) << "Kernel" << std::right << std::setw(10) << "Size" << std::setw(5) << "Thr"
+              << std::setw(12) << "Base (ms)" << std::setw(12) << "New (ms)" << std::setw(9) << "Ratio"
+              << std::setw(9) << "Limit" << "  Status\n";
+
+    int slower = 0;
+    for (const Result& r : results) {
+        auto it = byKey.find(result_key(r.kernel, r.size, r.threads, r.ranks));
+        if (it == byKey.end()) continue;
+        const json::Value& b = *it->second;
+        double base = b["median_ms"].number;
+        double baseCv = b["cv"].number;
+        double ratio = base > 0 ? r.median / base : 1.0;
+        double limit = threshold + 2.0 * std::sqrt(r.cv * r.cv + baseCv * baseCv);
+        std::string status = "same";
+        if (ratio > 1.0 + limit) {
+            status = "SLOWER";
+            slower++;
+        } else if (ratio < 1.0 / (1.0 + limit)) {
+            status = "faster";
+        }
+        std::cout << std::left << std::setw(18) << r.kernel << std::right << std::setw(10) << r.size << std::setw(5)
+                  << r.threads << std::fixed << std::setprecision(3) << std::setw(12) << base << std::setw(12) << r.median
+                  << std::setprecision(2) << std::setw(8) << ratio << "x" << std::setw(8) << 1.0 + limit << "x"
+                  << "  " << status << "\n";
+    }
+    std::cout << slower << " slowdown(s) beyond the noise threshold." << std::endl;
+    return slower;
+}
+
+// ---------------------------------------------------------------------------
+// Command line
+
+template<typename V>
+std::vector<V> parse_list(const std::string& text) {
+    std::vector<V> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        std::stringstream is(item);
+        V v;
+        if (is >> v) values.push_back(v);
+    }
+    return values;
+}
+
+bool selected(const Kernel& kernel, const BenchConfig& cfg) {
+    for (const std::string& pattern : cfg.kernels) {
+        if (fnmatch(pattern.c_str(), kernel.name.c_str(), 0) == 0) return true;
+    }
+    return false;
+}
+
+void print_usage() {
+    std::cout << "Usage: hpc_bench [--kernel a,b*] [--sizes n,...] [--threads t,...] [--repeat r] [--warmup w]\n"
+                 "                 [--pin] [--json out.json] [--baseline base.json] [--threshold 0.05] [--list]\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchContext ctx;
+#ifdef HPC_WITH_MPI
+    int thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
+    MPI_Comm_rank(MPI_COMM_WORLD, &ctx.rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ctx.ranks);
+#endif
+
+    BenchConfig cfg;
+    bool bad = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--kernel" && has_value) {
+            cfg.kernels = parse_list<std::string>(argv[++i]);
+        } else if (arg == "--sizes" && has_value) {
+            cfg.sizes = parse_list<long long>(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            cfg.threads = parse_list<int>(argv[++i]);
+        } else if (arg == "--repeat" && has_value) {
+            cfg.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--warmup" && has_value) {
+            cfg.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--pin") {
+            cfg.pin = true;
+        } else if (arg == "--json" && has_value) {
+            cfg.json_path = argv[++i];
+        } else if (arg == "--baseline" && has_value) {
+            cfg.baseline_path = argv[++i];
+        } else if (arg == "--threshold" && has_value) {
+            cfg.threshold = std::atof(argv[++i]);
+        } else if (arg == "--list") {
+            cfg.list = true;
+        } else {
+            bad = true;
+        }
+    }
+    if (cfg.threads.empty()) cfg.threads.push_back(omp_get_max_threads());
+    ctx.pin = cfg.pin;
+    bool root = ctx.rank == 0;
+
+    std::vector<Kernel> kernels = all_kernels();
+    if (bad || cfg.list) {
+        if (root) {
+            if (bad) print_usage();
+            for (const Kernel& k : kernels) {
+                std::cout << std::left << std::setw(18) << k.name << " sizes";
+                for (long long s : k.sizes) std::cout << " " << s;
+                std::cout << (k.threaded ? "" : "  (sequential)") << (k.collective ? "  (MPI)" : "") << "\n";
+            }
+        }
+#ifdef HPC_WITH_MPI
+        MPI_Finalize();
+#endif
+        return bad ? 1 : 0;
+    }
+
+    if (root) {
+        std::cout << std::left << std::setw(18) << "Kernel" << std::right << std::setw(10) << "Size" << std::setw(5) << "Thr"
+                  << std::setw(6) << "Ranks" << std::setw(12) << "Median (ms)" << std::setw(12) << "Min (ms)"
+                  << std::setw(8) << "CV" << "  Check\n";
+    }
+
+    std::vector<Result> results;
+    bool all_verified = true;
+    for (const Kernel& kernel : kernels) {
+        if (!selected(kernel, cfg)) continue;
+        if (!kernel.collective && !root) continue;
+        const std::vector<long long>& sizes = cfg.sizes.empty() ? kernel.sizes : cfg.sizes;
+        std::vector<int> threads = kernel.threaded ? cfg.threads : std::vector<int>(1, 1);
+        for (long long size : sizes) {
+            for (int t : threads) {
+                Result r = run_kernel(kernel, size, t, cfg, ctx);
+                all_verified = all_verified && r.verified;
+                if (!root) continue;
+                std::cout << std::left << std::setw(18) << r.kernel << std::right << std::setw(10) << r.size
+                          << std::setw(5) << r.threads << std::setw(6) << r.ranks << std::fixed << std::setprecision(3)
+                          << std::setw(12) << r.median << std::setw(12) << r.min << std::setprecision(3) << std::setw(8)
+                          << r.cv << "  " << (r.verified ? "ok" : "FAILED") << std::endl;
+                results.push_back(r);
+            }
+        }
+    }
+
+    int status = all_verified ? 0 : 1;
+    if (root) {
+        perf::report();
+        if (!cfg.json_path.empty()) write_json(cfg.json_path, results, cfg);
+        if (!cfg.baseline_path.empty() && compare_with_baseline(cfg.baseline_path, results, cfg.threshold) > 0 && status == 0) {
+            status = 2;
+        }
+    }
+#ifdef HPC_WITH_MPI
+    MPI_Finalize();
+#endif
+    return status;
+}
+
+/*
+Command -> g++ -O2 -fopenmp -pthread hpc_bench.cpp ../hpc/graph.cpp ../hpc/dynamic_graph.cpp ../hpc/dataflow.cpp ../hpc/sorting.cpp ../hpc/reduction.cpp -o hpc_bench
+MPI     -> mpic++ -O2 -fopenmp -pthread -DHPC_WITH_MPI hpc_bench.cpp ../hpc/graph.cpp ../hpc/dynamic_graph.cpp ../hpc/dataflow.cpp ../hpc/sorting.cpp ../hpc/reduction.cpp -o hpc_bench
+CMake   -> cmake -S .. -B ../build && cmake --build ../build --target hpc_bench
+
+./hpc_bench --list
+./hpc_bench --kernel 'merge.*,bfs.ws' --threads 1,2,4 --repeat 7 --pin --json base.json
+./hpc_bench --kernel 'merge.*,bfs.ws' --threads 1,2,4 --repeat 7 --pin --baseline base.json
+mpirun -np 4 ./hpc_bench --kernel sample_sort --threads 1
+
+Exit status: 0 when every kernel verified and nothing regressed, 1 when a
+kernel produced a wrong answer, 2 when a kernel is slower than the
+baseline beyond the threshold.
+*/
@@ -0,0 +1,186 @@
+// Just enough JSON for hpc_bench to write its results and read a saved
+// baseline back: a value tree, a recursive-descent parser that throws
+// std::runtime_error on malformed input, and string quoting for the writer.
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace json {
+
+struct Value {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<Value> items;
+    std::map<std::string, Value> members;
+
+    bool has(const std::string& key) const { return type == OBJECT && members.count(key) != 0; }
+
+    const Value& operator[](const std::string& key) const {
+        auto it = members.find(key);
+        if (type != OBJECT || it == members.end()) throw std::runtime_error("missing JSON member \"" + key + "\"");
+        return it->second;
+    }
+};
+
+inline std::string quote(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+namespace detail {
+
+class Parser {
+private:
+    const std::string& s;
+    size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error("JSON: " + what + " at offset " + std::to_string(pos));
+    }
+
+    void skipSpace() {
+        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\n' || s[pos] == '\r' || s[pos] == '\t')) pos++;
+    }
+
+    void expect(char c) {
+        skipSpace();
+        if (pos >= s.size() || s[pos] != c) fail(std::string("expected '") + c + "'");
+        pos++;
+    }
+
+    bool consume(const char* word) {
+        size_t n = std::char_traits<char>::length(word);
+        if (s.compare(pos, n, word) != 0) return false;
+        pos += n;
+        return true;
+    }
+
+    std::string parseString() {
+        expect('"');
+        std::string out;
+        while (pos < s.size() && s[pos] != '"') {
+            char c = s[pos++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= s.size()) break;
+            char e = s[pos++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    // Only what quote() emits: control characters.
+                    if (pos + 4 > s.size()) fail("short \\u escape");
+                    out += static_cast<char>(std::strtol(s.substr(pos, 4).c_str(), nullptr, 16));
+                    pos += 4;
+                    break;
+                }
+                default: out += e;
+            }
+        }
+        if (pos >= s.size()) fail("unterminated string");
+        pos++;
+        return out;
+    }
+
+public:
+    explicit Parser(const std::string& text) : s(text) {}
+
+    Value parseValue() {
+        skipSpace();
+        if (pos >= s.size()) fail("unexpected end");
+        Value v;
+        char c = s[pos];
+        if (c == '{') {
+            v.type = Value::OBJECT;
+            pos++;
+            skipSpace();
+            if (pos < s.size() && s[pos] == '}') {
+                pos++;
+                return v;
+            }
+            do {
+                std::string key = parseString();
+                expect(':');
+                v.members[key] = parseValue();
+                skipSpace();
+            } while (pos < s.size() && s[pos] == ',' && ++pos);
+            expect('}');
+        } else if (c == '[') {
+            v.type = Value::ARRAY;
+            pos++;
+            skipSpace();
+            if (pos < s.size() && s[pos] == ']') {
+                pos++;
+                return v;
+            }
+            do {
+                v.items.push_back(parseValue());
+                skipSpace();
+            } while (pos < s.size() && s[pos] == ',' && ++pos);
+            expect(']');
+        } else if (c == '"') {
+            v.type = Value::STRING;
+            v.text = parseString();
+        } else if (consume("true")) {
+            v.type = Value::BOOLEAN;
+            v.boolean = true;
+        } else if (consume("false")) {
+            v.type = Value::BOOLEAN;
+        } else if (consume("null")) {
+            v.type = Value::NUL;
+        } else {
+            char* end = nullptr;
+            v.type = Value::NUMBER;
+            v.number = std::strtod(s.c_str() + pos, &end);
+            if (end == s.c_str() + pos) fail("unexpected character");
+            pos = end - s.c_str();
+        }
+        return v;
+    }
+
+    void finish() {
+        skipSpace();
+        if (pos != s.size()) fail("trailing characters");
+    }
+};
+
+} // namespace detail
+
+inline Value parse(const std::string& text) {
+    detail::Parser parser(text);
+    Value v = parser.parseValue();
+    parser.finish();
+    return v;
+}
+
+} // namespace json
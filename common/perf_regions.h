@@ -0,0 +1,395 @@
+// Per-region hardware counters and a roofline summary.
+//
+// Compile with -DPERF_REGIONS to enable. Without it, Region is an empty
+// object and report() does nothing, so the practicals print exactly what
+// they printed before.
+//
+//   {
+//       perf::Region region("Parallel Sum", ops, bytes);
+//       parallelSum();
+//   }
+//   perf::report();
+//
+// ops and bytes are the work the kernel has to do: element operations
+// (comparisons, additions, edge visits) and compulsory memory traffic.
+// The counters add what actually happened: cycles, instructions, LLC misses
+// (reported as bytes moved, one cache line per miss) and branch
+// mispredictions. The counters are opened with perf_event_open once, at
+// program start-up and before any thread exists, with inherit set: every
+// thread started later (the OpenMP team, work-stealing workers, plain
+// std::threads) counts into them, and a read returns the total of all of
+// them, live or exited. A region reads that total on entry and on exit,
+// so it sees every thread's work whichever runtime ran the kernel; open
+// and close it outside parallel regions, from the thread that launches
+// the kernel. The price is that per-thread counts are not available: a
+// region's counters are one row for the whole process (one per rank once
+// MPI reports are merged).
+//
+// Counters that the kernel or the machine does not provide, for example
+// under a high perf_event_paranoid or in a VM without a virtual PMU, are
+// reported as n/a; the roofline then falls back to the declared traffic.
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef PERF_REGIONS
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace perf {
+
+enum Event { CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, NUM_EVENTS };
+
+const double CACHE_LINE_BYTES = 64.0;
+
+// Counter values; -1 marks an event that could not be counted, and stays
+// -1 through every sum it takes part in.
+struct Counters {
+    double value[NUM_EVENTS];
+
+    Counters() {
+        for (int e = 0; e < NUM_EVENTS; e++) value[e] = 0.0;
+    }
+
+    bool has(int e) const { return value[e] >= 0.0; }
+
+    void add(const Counters& other, double sign = 1.0) {
+        for (int e = 0; e < NUM_EVENTS; e++) {
+            value[e] = has(e) && other.has(e) ? value[e] + sign * other.value[e] : -1.0;
+        }
+    }
+};
+
+// A breakdown line of a region: the whole process, or one rank once
+// reports are merged across MPI ranks. Never a single thread.
+struct BreakdownRow {
+    std::string label;
+    Counters counters;
+};
+
+struct RegionSummary {
+    std::string name;
+    long calls = 0;
+    double seconds = 0.0;
+    double ops = 0.0;
+    double bytes = 0.0;
+    std::vector<BreakdownRow> rows;
+
+    Counters total() const {
+        Counters sum;
+        for (const BreakdownRow& row : rows) sum.add(row.counters);
+        return sum;
+    }
+};
+
+// Roofs of the roofline: scalar integer operations (what these kernels
+// execute) and read bandwidth from memory, both for all threads.
+struct Ceilings {
+    double gops = 0.0;
+    double gbs = 0.0;
+};
+
+inline std::string formatCount(double value) {
+    if (value < 0.0) return "n/a";
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(value < 1e4 ? 0 : 2);
+    if (value >= 1e9) out << value / 1e9 << "G";
+    else if (value >= 1e6) out << value / 1e6 << "M";
+    else if (value >= 1e4) out << value / 1e3 << "K";
+    else out << value;
+    return out.str();
+}
+
+// One line per region with the roofline verdict, then one line per
+// breakdown row with its raw counters.
+inline void printReport(const std::vector<RegionSummary>& regions, const Ceilings& roof, std::ostream& os = std::cout) {
+    if (regions.empty()) return;
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    double ridge = roof.gbs > 0.0 ? roof.gops / roof.gbs : 0.0;
+
+    os << "------------------------------------------------------------" << std::endl;
+    os << std::fixed << std::setprecision(2);
+    os << "Roofline: " << roof.gops << " Gop/s (scalar integer), " << roof.gbs << " GB/s (memory read), ridge at "
+       << ridge << " op/B" << std::endl;
+    bool counted = false;
+    for (const RegionSummary& r : regions) {
+        Counters total = r.total();
+        for (int e = 0; e < NUM_EVENTS; e++) counted = counted || total.has(e);
+    }
+    if (counted) {
+        os << "Bytes are max(declared traffic, LLC misses x " << std::setprecision(0) << CACHE_LINE_BYTES << " B)"
+           << std::setprecision(2) << std::endl;
+    } else {
+        os << "Hardware counters unavailable (perf_event_open refused or no PMU): bytes are the declared traffic"
+           << std::endl;
+    }
+    os << std::left << std::setw(24) << "Region" << std::right << std::setw(6) << "Calls" << std::setw(11) << "Time ms"
+       << std::setw(7) << "IPC" << std::setw(10) << "Bytes" << std::setw(9) << "GB/s" << std::setw(9) << "Gop/s"
+       << std::setw(8) << "op/B" << std::setw(9) << "Roof" << std::setw(8) << "% roof" << "  Bound" << std::endl;
+
+    for (const RegionSummary& r : regions) {
+        Counters total = r.total();
+        double bytes = r.bytes;
+        if (total.has(LLC_MISSES)) bytes = std::max(bytes, total.value[LLC_MISSES] * CACHE_LINE_BYTES);
+        double seconds = std::max(r.seconds, 1e-12);
+        double gops = r.ops / seconds / 1e9;
+        double gbs = bytes / seconds / 1e9;
+        // A region that declares no traffic (splitter selection, say) sits
+        // under the flat part of the roof.
+        double intensity = bytes > 0.0 ? r.ops / bytes : 1e30;
+        double attainable = std::min(roof.gops, intensity * roof.gbs);
+        std::string intensityText = "-";
+        if (bytes > 0.0) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(2) << intensity;
+            intensityText = out.str();
+        }
+        std::string ipc = "n/a";
+        if (total.has(CYCLES) && total.has(INSTRUCTIONS) && total.value[CYCLES] > 0.0) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(2) << total.value[INSTRUCTIONS] / total.value[CYCLES];
+            ipc = out.str();
+        }
+
+        os << std::left << std::setw(24) << r.name.substr(0, 23) << std::right << std::setw(6) << r.calls
+           << std::setw(11) << std::setprecision(3) << r.seconds * 1000 << std::setw(7) << ipc << std::setw(10)
+           << formatCount(bytes) << std::setprecision(2) << std::setw(9) << gbs << std::setw(9) << gops
+           << std::setw(8) << intensityText << std::setw(9) << attainable << std::setw(7)
+           << (attainable > 0.0 ? 100.0 * gops / attainable : 0.0) << "%  "
+           << (intensity < ridge ? "memory" : "compute") << std::endl;
+
+        for (size_t i = 0; counted && i < r.rows.size(); i++) {
+            const BreakdownRow& row = r.rows[i];
+            const Counters& c = row.counters;
+            double mpki = c.has(BRANCH_MISSES) && c.has(INSTRUCTIONS) && c.value[INSTRUCTIONS] > 0.0
+                              ? 1000.0 * c.value[BRANCH_MISSES] / c.value[INSTRUCTIONS] : -1.0;
+            os << "    " << std::left << std::setw(18) << row.label << std::right
+               << "cycles " << std::setw(8) << formatCount(c.value[CYCLES])
+               << "  instr " << std::setw(8) << formatCount(c.value[INSTRUCTIONS])
+               << "  LLC miss " << std::setw(8) << formatCount(c.value[LLC_MISSES])
+               << "  bytes " << std::setw(8) << formatCount(c.has(LLC_MISSES) ? c.value[LLC_MISSES] * CACHE_LINE_BYTES : -1.0)
+               << "  br miss " << std::setw(8) << formatCount(c.value[BRANCH_MISSES]);
+            if (mpki >= 0.0) os << " (" << std::setprecision(2) << mpki << " MPKI)";
+            os << std::endl;
+        }
+    }
+    os << "------------------------------------------------------------" << std::endl;
+    os.flags(flags);
+    os.precision(precision);
+}
+
+#ifdef PERF_REGIONS
+
+const bool enabled = true;
+
+namespace detail {
+
+// Counts this process (pid 0, any CPU) and, through inherit, the threads
+// it starts afterwards; user space only so that perf_event_paranoid up to
+// 2 still allows it.
+inline int openEvent(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+class ProcessCounters {
+private:
+    int fd[NUM_EVENTS];
+
+public:
+    ProcessCounters() {
+        fd[CYCLES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fd[INSTRUCTIONS] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fd[LLC_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fd[BRANCH_MISSES] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    }
+
+    ~ProcessCounters() {
+        for (int e = 0; e < NUM_EVENTS; e++) {
+            if (fd[e] >= 0) close(fd[e]);
+        }
+    }
+
+    ProcessCounters(const ProcessCounters&) = delete;
+    ProcessCounters& operator=(const ProcessCounters&) = delete;
+
+    // Scaled by enabled/running time in case the PMU multiplexes events.
+    Counters read() const {
+        Counters c;
+        for (int e = 0; e < NUM_EVENTS; e++) {
+            uint64_t data[3] = {0, 0, 0};
+            if (fd[e] < 0 || ::read(fd[e], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+                c.value[e] = -1.0;
+                continue;
+            }
+            c.value[e] = data[2] > 0 ? static_cast<double>(data[0]) * data[1] / data[2] : 0.0;
+        }
+        return c;
+    }
+};
+
+inline ProcessCounters& process() {
+    static ProcessCounters counters;
+    return counters;
+}
+
+// Every translation unit that includes this header opens the counters
+// during static initialization, before main can start a thread that
+// would otherwise escape inherit.
+static const bool processCountersOpened = (process(), true);
+
+inline int maxThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+inline std::vector<RegionSummary>& registry() {
+    static std::vector<RegionSummary> regions;
+    return regions;
+}
+
+inline RegionSummary& entry(const std::string& name) {
+    std::vector<RegionSummary>& regions = registry();
+    for (RegionSummary& r : regions) {
+        if (r.name == name) return r;
+    }
+    regions.push_back(RegionSummary());
+    regions.back().name = name;
+    return regions.back();
+}
+
+} // namespace detail
+
+class Region {
+private:
+    std::string name;
+    double ops, bytes;
+    Counters start;
+    std::chrono::high_resolution_clock::time_point begin;
+
+public:
+    Region(const std::string& regionName, double regionOps, double regionBytes)
+        : name(regionName), ops(regionOps), bytes(regionBytes) {
+        start = detail::process().read();
+        begin = std::chrono::high_resolution_clock::now();
+    }
+
+    ~Region() {
+        auto end = std::chrono::high_resolution_clock::now();
+        Counters stop = detail::process().read();
+
+        RegionSummary& r = detail::entry(name);
+        r.calls++;
+        r.seconds += std::chrono::duration<double>(end - begin).count();
+        r.ops += ops;
+        r.bytes += bytes;
+        if (r.rows.empty()) {
+            BreakdownRow row;
+            row.label = "process";
+            r.rows.push_back(row);
+        }
+        stop.add(start, -1.0);
+        r.rows[0].counters.add(stop);
+    }
+
+    Region(const Region&) = delete;
+    Region& operator=(const Region&) = delete;
+};
+
+inline std::vector<RegionSummary> collect() {
+    return detail::registry();
+}
+
+// Compute roof: eight independent add chains per thread, kept in registers
+// and out of the vectoriser by an empty asm. Memory roof: a parallel sum
+// over an array far larger than the caches, first-touched by the threads
+// that read it.
+inline Ceilings measureCeilings(size_t bandwidthBytes = size_t(1) << 28) {
+    Ceilings roof;
+    const long iterations = 1L << 26;
+    int threads = detail::maxThreads();
+    double best = 1e30;
+    for (int run = 0; run < 3; run++) {
+        auto begin = std::chrono::high_resolution_clock::now();
+        #pragma omp parallel num_threads(threads)
+        {
+            uint64_t a0 = 0, a1 = 1, a2 = 2, a3 = 3, a4 = 4, a5 = 5, a6 = 6, a7 = 7;
+            for (long i = 0; i < iterations; i++) {
+                a0 += i; a1 += i; a2 += i; a3 += i; a4 += i; a5 += i; a6 += i; a7 += i;
+                asm volatile("" : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4), "+r"(a5), "+r"(a6), "+r"(a7));
+            }
+            volatile uint64_t keep = a0 ^ a1 ^ a2 ^ a3 ^ a4 ^ a5 ^ a6 ^ a7;
+            (void)keep;
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count());
+    }
+    roof.gops = 8.0 * iterations * threads / best / 1e9;
+
+    long n = static_cast<long>(bandwidthBytes / sizeof(int64_t));
+    std::vector<int64_t> data(n);
+    #pragma omp parallel for schedule(static) num_threads(threads)
+    for (long i = 0; i < n; i++) data[i] = i;
+    best = 1e30;
+    for (int run = 0; run < 3; run++) {
+        int64_t sum = 0;
+        auto begin = std::chrono::high_resolution_clock::now();
+        #pragma omp parallel for schedule(static) reduction(+:sum) num_threads(threads)
+        for (long i = 0; i < n; i++) sum += data[i];
+        best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count());
+        volatile int64_t keep = sum;
+        (void)keep;
+    }
+    roof.gbs = n * sizeof(int64_t) / best / 1e9;
+    return roof;
+}
+
+inline void report(std::ostream& os = std::cout) {
+    printReport(collect(), measureCeilings(), os);
+}
+
+#else
+
+const bool enabled = false;
+
+class Region {
+public:
+    Region(const std::string&, double, double) {}
+};
+
+inline std::vector<RegionSummary> collect() {
+    return std::vector<RegionSummary>();
+}
+
+inline Ceilings measureCeilings(size_t = 0) {
+    return Ceilings();
+}
+
+inline void report(std::ostream& = std::cout) {}
+
+#endif
+
+} // namespace perf
@@ -0,0 +1,349 @@
+// A streaming pipeline: stages on their own threads, joined by bounded
+// lock-free queues of chunks.
+//
+//   pipeline::Channel<Chunk> raw(8, 1, sorters);   // capacity, producers, consumers
+//   pipeline::Pipeline p;
+//   p.stage("generate", 1, [&](int, pipeline::StageStats& s) {
+//       for (...) raw.push(makeChunk(), s);
+//       raw.close();
+//   });
+//   p.stage("sort", sorters, [&](int, pipeline::StageStats& s) {
+//       Chunk c;
+//       while (raw.pop(c, s)) { ... }
+//   });
+//   p.run();
+//   p.report(std::cout);
+//
+// A producer waits while its queue is full and a consumer while its queue
+// is empty, so at most capacity chunks wait between two stages and memory
+// stays bounded however long the stream is. Waiting is polling, not
+// parking: 64 yields, then a retry every 20 microseconds. Every stage
+// thread accounts for its time as busy, waiting for input (the stage
+// upstream is slower) or waiting for room in its output (the stage
+// downstream is slower); the report turns this into per-stage throughput
+// and names the stage that limits the pipeline.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+// Single-producer single-consumer ring: each side owns one index and only
+// reads the other's, so a push or pop is one acquire load and one release
+// store. Capacity is rounded up to a power of two.
+template<typename T>
+class SpscQueue {
+private:
+    size_t mask;
+    std::unique_ptr<T[]> slots;
+    alignas(64) std::atomic<size_t> head;  // next slot to pop
+    alignas(64) std::atomic<size_t> tail;  // next slot to push
+
+public:
+    explicit SpscQueue(size_t capacity) : head(0), tail(0) {
+        size_t n = 1;
+        while (n < capacity) n *= 2;
+        mask = n - 1;
+        slots.reset(new T[n]);
+    }
+
+    bool tryPush(T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask) return false;
+        slots[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Bounded multi-producer multi-consumer queue (Vyukov's): every cell has a
+// sequence number that tells a producer the cell is free for its ticket and
+// a consumer that it holds the item for its ticket, so contention is one
+// compare-and-swap on the shared index. Capacity is rounded up to a power
+// of two, and to at least two.
+template<typename T>
+class MpmcQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+
+public:
+    explicit MpmcQueue(size_t capacity) : enqueuePos(0), dequeuePos(0) {
+        size_t n = 2;
+        while (n < capacity) n *= 2;
+        mask = n - 1;
+        cells.reset(new Cell[n]);
+        for (size_t i = 0; i < n; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(T& item) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            long diff = static_cast<long>(seq) - static_cast<long>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.item = std::move(item);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& item) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            long diff = static_cast<long>(seq) - static_cast<long>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = std::move(cell.item);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+// Per-stage counters, shared by the stage's threads. items and bytes are
+// what the stage reports having processed; the wait times are filled in by
+// the channels and the busy time by the executor.
+struct StageStats {
+    std::string name;
+    int threads = 0;
+    std::atomic<long long> items{0};
+    std::atomic<long long> bytes{0};
+    std::atomic<long long> busyNs{0};
+    std::atomic<long long> inputWaitNs{0};
+    std::atomic<long long> outputWaitNs{0};
+
+    void add(long long n, long long b) {
+        items.fetch_add(n, std::memory_order_relaxed);
+        bytes.fetch_add(b, std::memory_order_relaxed);
+    }
+};
+
+namespace detail {
+
+// Retries attempt() until it succeeds or done() says it never will: 64
+// times with a yield in between, then every 20 microseconds. A stalled
+// stage costs little CPU this way, but it may notice new room or input up
+// to one nap late. Time spent here is charged to waited.
+template<typename Attempt, typename Done>
+bool waitFor(const Attempt& attempt, const Done& done, std::atomic<long long>& waited) {
+    if (attempt()) return true;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = false;
+    for (long tries = 1;; tries++) {
+        if (attempt()) {
+            ok = true;
+            break;
+        }
+        if (done()) {
+            ok = attempt();
+            break;
+        }
+        if (tries < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    waited.fetch_add(ns, std::memory_order_relaxed);
+    return ok;
+}
+
+} // namespace detail
+
+// A bounded, closable queue between two stages: the SPSC ring when one
+// thread feeds one thread, the MPMC queue otherwise. The queues round their
+// capacity up, so the channel counts the items it holds and refuses a push
+// at the exact capacity it was given. Each producer thread calls close()
+// once when it is done; consumers drain what is left and then see pop()
+// return false.
+template<typename T>
+class Channel {
+private:
+    std::unique_ptr<SpscQueue<T>> spsc;
+    std::unique_ptr<MpmcQueue<T>> mpmc;
+    size_t bound;
+    std::atomic<size_t> held;  // pushed or being pushed, and not yet popped
+    std::atomic<int> openProducers;
+
+    // A slot is reserved in held before the queue is touched, and released
+    // only once the pop has freed its cell, so a reserved push always finds
+    // room in the queue.
+    bool tryPush(T& item) {
+        size_t n = held.load(std::memory_order_relaxed);
+        do {
+            if (n >= bound) return false;
+        } while (!held.compare_exchange_weak(n, n + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+        bool pushed = spsc ? spsc->tryPush(item) : mpmc->tryPush(item);
+        if (!pushed) held.fetch_sub(1, std::memory_order_release);
+        return pushed;
+    }
+
+    bool tryPop(T& item) {
+        bool popped = spsc ? spsc->tryPop(item) : mpmc->tryPop(item);
+        if (popped) held.fetch_sub(1, std::memory_order_release);
+        return popped;
+    }
+
+public:
+    Channel(size_t capacity, int producers, int consumers)
+        : bound(std::max<size_t>(1, capacity)), held(0), openProducers(producers) {
+        if (producers == 1 && consumers == 1) {
+            spsc.reset(new SpscQueue<T>(capacity));
+        } else {
+            mpmc.reset(new MpmcQueue<T>(capacity));
+        }
+    }
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    size_t capacity() const { return bound; }
+
+    // Polls while the queue is full; the wait is charged to the pushing
+    // stage as output wait.
+    void push(T item, StageStats& stats) {
+        detail::waitFor([&] { return tryPush(item); }, [] { return false; }, stats.outputWaitNs);
+    }
+
+    // Polls while the queue is empty and a producer is still open; false
+    // once it is closed and drained. The wait is charged as input wait.
+    bool pop(T& item, StageStats& stats) {
+        return detail::waitFor([&] { return tryPop(item); },
+                               [&] { return openProducers.load(std::memory_order_acquire) == 0; },
+                               stats.inputWaitNs);
+    }
+
+    void close() { openProducers.fetch_sub(1, std::memory_order_acq_rel); }
+};
+
+class Pipeline {
+private:
+    struct Stage {
+        std::unique_ptr<StageStats> stats;
+        std::function<void(int, StageStats&)> body;
+    };
+
+    std::vector<Stage> stages;
+    double wallSeconds = 0.0;
+
+public:
+    // body(threadIndex, stats) runs on each of the stage's threads.
+    void stage(const std::string& name, int threads, std::function<void(int, StageStats&)> body) {
+        Stage s;
+        s.stats.reset(new StageStats());
+        s.stats->name = name;
+        s.stats->threads = std::max(1, threads);
+        s.body = std::move(body);
+        stages.push_back(std::move(s));
+    }
+
+    // Starts every stage at once and returns when all have finished.
+    void run() {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (Stage& s : stages) {
+            for (int t = 0; t < s.stats->threads; t++) {
+                threads.emplace_back([&s, t] {
+                    auto begin = std::chrono::steady_clock::now();
+                    s.body(t, *s.stats);
+                    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+                    s.stats->busyNs.fetch_add(ns, std::memory_order_relaxed);
+                });
+            }
+        }
+        for (std::thread& t : threads) t.join();
+        wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // Each thread added its whole lifetime; what it spent waiting is
+        // not busy.
+        for (Stage& s : stages) {
+            StageStats& st = *s.stats;
+            st.busyNs.fetch_sub(st.inputWaitNs.load() + st.outputWaitNs.load(), std::memory_order_relaxed);
+        }
+    }
+
+    double seconds() const { return wallSeconds; }
+    const StageStats& stats(size_t i) const { return *stages[i].stats; }
+    size_t size() const { return stages.size(); }
+
+    // Per stage: what it processed, its throughput over the whole run and
+    // over its busy time alone (what it could sustain if it never waited),
+    // and how its thread time split between work, starving for input and
+    // waiting on output. The stage with the largest busy share is the one
+    // the pipeline runs at.
+    void report(std::ostream& os) const {
+        os << std::fixed << std::setprecision(1);
+        os << std::left << std::setw(12) << "Stage" << std::right << std::setw(5) << "Thr" << std::setw(9) << "Items"
+           << std::setw(10) << "MB" << std::setw(10) << "MB/s" << std::setw(12) << "Busy MB/s" << std::setw(8) << "Busy"
+           << std::setw(10) << "In wait" << std::setw(10) << "Out wait" << "\n";
+        size_t bottleneck = 0;
+        double bottleneckShare = -1.0;
+        for (size_t i = 0; i < stages.size(); i++) {
+            const StageStats& s = *stages[i].stats;
+            double threadNs = wallSeconds * 1e9 * s.threads;
+            double busy = threadNs > 0 ? s.busyNs.load() / threadNs : 0.0;
+            double in = threadNs > 0 ? s.inputWaitNs.load() / threadNs : 0.0;
+            double out = threadNs > 0 ? s.outputWaitNs.load() / threadNs : 0.0;
+            double mb = s.bytes.load() / 1e6;
+            double busySeconds = s.busyNs.load() / 1e9 / s.threads;
+            os << std::left << std::setw(12) << s.name << std::right << std::setw(5) << s.threads << std::setw(9)
+               << s.items.load() << std::setw(10) << mb << std::setw(10) << (wallSeconds > 0 ? mb / wallSeconds : 0.0)
+               << std::setw(12) << (busySeconds > 0 ? mb / busySeconds : 0.0) << std::setw(7) << busy * 100 << "%"
+               << std::setw(9) << in * 100 << "%" << std::setw(9) << out * 100 << "%\n";
+            if (busy > bottleneckShare) {
+                bottleneckShare = busy;
+                bottleneck = i;
+            }
+        }
+        if (!stages.empty()) {
+            os << "Pipeline: " << std::setprecision(3) << wallSeconds * 1e3 << " ms, limited by \""
+               << stages[bottleneck].stats->name << "\" (busy " << std::setprecision(1) << bottleneckShare * 100
+               << "% of its thread time)\n";
+        }
+    }
+};
+
+} // namespace pipeline
@@ -0,0 +1,426 @@
+// A persistent fork-join runtime with work stealing.
+//
+//   ws::Scheduler pool(8);                 // the calling thread is worker 0
+//   pool.parallelFor(0, n, 4096, [&](long lo, long hi) { ... });
+//
+//   ws::TaskGroup group(pool);
+//   group.spawn([&] { left(); });
+//   right();
+//   group.sync();
+//
+// The worker threads are started once and live as long as the Scheduler,
+// so a parallel loop or a spawn costs a deque push and, at most, waking a
+// sleeping worker, not a thread team fork and join. Every worker owns a
+// Chase-Lev deque: it pushes and pops its own tasks at the bottom, and
+// idle workers steal from the top of a randomly chosen victim, which is
+// where the oldest and therefore largest pieces of work sit. A thread
+// waiting in sync() runs tasks instead of blocking, so nested groups
+// cannot deadlock. Idle workers spin briefly, then sleep until new work
+// is pushed.
+//
+// The workers are plain threads started after program start-up, so a
+// perf::Region around a kernel on the pool counts them through the
+// inherited process counters, brief idle spinning included.
+//
+// Only the thread that constructed the Scheduler, and tasks running on
+// it, may start work; anywhere else spawn() simply runs the task inline.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace ws {
+
+class Task {
+public:
+    std::atomic<long>* pending = nullptr;
+    virtual ~Task() {}
+    virtual void run() = 0;
+};
+
+template<typename F>
+class FunctionTask : public Task {
+private:
+    F function;
+
+public:
+    explicit FunctionTask(F&& f) : function(std::move(f)) {}
+    explicit FunctionTask(const F& f) : function(f) {}
+    void run() override { function(); }
+};
+
+// Chase-Lev work-stealing deque (the C11 formulation of Le et al., 2013).
+// push and pop are owner-only; steal may be called by any thread and
+// returns nullptr when the deque is empty or another thief won the race.
+class WorkDeque {
+private:
+    struct Array {
+        long capacity;
+        std::unique_ptr<std::atomic<Task*>[]> slots;
+
+        explicit Array(long n) : capacity(n), slots(new std::atomic<Task*>[n]) {}
+        // Release/acquire on the slot itself (free on x86) also publishes
+        // the task's contents to the thief that reads it.
+        Task* get(long i) const { return slots[i & (capacity - 1)].load(std::memory_order_acquire); }
+        void put(long i, Task* t) { slots[i & (capacity - 1)].store(t, std::memory_order_release); }
+    };
+
+    alignas(64) std::atomic<long> top;
+    alignas(64) std::atomic<long> bottom;
+    std::atomic<Array*> array;
+    // Thieves may still be reading an outgrown array, so it is only freed
+    // with the deque.
+    std::vector<std::unique_ptr<Array>> arrays;
+
+    Array* grow(Array* old, long t, long b) {
+        arrays.emplace_back(new Array(old->capacity * 2));
+        Array* bigger = arrays.back().get();
+        for (long i = t; i < b; i++) bigger->put(i, old->get(i));
+        array.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+public:
+    explicit WorkDeque(long capacity = 1024) : top(0), bottom(0) {
+        arrays.emplace_back(new Array(capacity));
+        array.store(arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkDeque(const WorkDeque&) = delete;
+    WorkDeque& operator=(const WorkDeque&) = delete;
+
+    bool empty() const {
+        return top.load(std::memory_order_acquire) >= bottom.load(std::memory_order_acquire);
+    }
+
+    void push(Task* task) {
+        long b = bottom.load(std::memory_order_relaxed);
+        long t = top.load(std::memory_order_acquire);
+        Array* a = array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) a = grow(a, t, b);
+        a->put(b, task);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    Task* pop() {
+        long b = bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Task* task = a->get(b);
+        if (t == b) {
+            // Last element: race the thieves for it.
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                task = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    Task* steal() {
+        long t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+        Task* task = array.load(std::memory_order_acquire)->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return task;
+    }
+};
+
+class Scheduler;
+
+namespace detail {
+
+struct Binding {
+    Scheduler* pool;
+    int index;
+};
+
+inline Binding& currentBinding() {
+    thread_local Binding binding = {nullptr, -1};
+    return binding;
+}
+
+} // namespace detail
+
+// Binds the calling thread to the index-th CPU it is allowed to run on,
+// wrapping around when there are more threads than CPUs. Returns false
+// where affinity cannot be set.
+inline bool pinCurrentThread(int index) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return false;
+    int count = CPU_COUNT(&allowed);
+    if (count == 0) return false;
+    int target = index % count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        if (target-- > 0) continue;
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(cpu, &one);
+        return sched_setaffinity(0, sizeof(one), &one) == 0;
+    }
+    return false;
+#else
+    (void)index;
+    return false;
+#endif
+}
+
+class Scheduler {
+private:
+    struct alignas(64) Worker {
+        WorkDeque deque;
+        std::minstd_rand rng;
+        explicit Worker(unsigned seed) : rng(seed) {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    detail::Binding ownerPrevious;
+    bool pinned;
+
+    std::atomic<bool> stopping;
+    std::atomic<int> searching;
+    std::atomic<int> sleeping;
+    std::atomic<unsigned> epoch;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+
+    // How long an idle worker keeps looking for work before it sleeps:
+    // long enough to bridge the gap between two parallel loops of a
+    // kernel, short enough not to compete with the next serial phase.
+    static constexpr long SPIN_MICROSECONDS = 200;
+
+    void execute(Task* task) {
+        std::atomic<long>* pending = task->pending;
+        task->run();
+        delete task;
+        pending->fetch_sub(1, std::memory_order_release);
+    }
+
+    Task* stealRandom(int self) {
+        int n = static_cast<int>(workers.size());
+        if (n < 2) return nullptr;
+        Worker& me = *workers[self];
+        for (int attempt = 0; attempt < n; attempt++) {
+            int victim = static_cast<int>(me.rng() % (n - 1));
+            if (victim >= self) victim++;
+            Task* task = workers[victim]->deque.steal();
+            if (task) return task;
+        }
+        return nullptr;
+    }
+
+    // Checks every deque until each is seen empty; the last look before
+    // sleeping must not give up on a victim it merely lost a race for.
+    Task* stealAny(int self) {
+        for (size_t v = 0; v < workers.size(); v++) {
+            if (static_cast<int>(v) == self) continue;
+            while (!workers[v]->deque.empty()) {
+                Task* task = workers[v]->deque.steal();
+                if (task) return task;
+            }
+        }
+        return nullptr;
+    }
+
+    Task* findTask(int self) {
+        Task* task = workers[self]->deque.pop();
+        return task ? task : stealRandom(self);
+    }
+
+    void workerLoop(int self) {
+        detail::currentBinding() = {this, self};
+        if (pinned) pinCurrentThread(self);
+        auto idleSince = std::chrono::steady_clock::now();
+        long misses = 0;
+        while (!stopping.load(std::memory_order_acquire)) {
+            Task* task = findTask(self);
+            if (task) {
+                if (misses > 0) searching.fetch_sub(1, std::memory_order_relaxed);
+                execute(task);
+                misses = 0;
+                continue;
+            }
+            if (misses++ == 0) {
+                searching.fetch_add(1, std::memory_order_seq_cst);
+                idleSince = std::chrono::steady_clock::now();
+            }
+            if (misses % 64 != 0) continue;
+            std::this_thread::yield();
+            if (std::chrono::steady_clock::now() - idleSince < std::chrono::microseconds(SPIN_MICROSECONDS)) continue;
+
+            // Announce the sleep before the last look, so that a push either
+            // is seen here or sees this worker asleep (and no one else still
+            // searching) and wakes it.
+            sleeping.fetch_add(1, std::memory_order_seq_cst);
+            searching.fetch_sub(1, std::memory_order_seq_cst);
+            unsigned seen = epoch.load(std::memory_order_seq_cst);
+            task = stealAny(self);
+            if (task) {
+                sleeping.fetch_sub(1, std::memory_order_relaxed);
+                execute(task);
+                misses = 0;
+                continue;
+            }
+            {
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                wakeUp.wait(lock, [&] {
+                    return epoch.load(std::memory_order_relaxed) != seen || stopping.load(std::memory_order_relaxed);
+                });
+            }
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+            misses = 0;
+        }
+    }
+
+public:
+    // With pin, worker i is bound to the i-th allowed CPU. The constructing
+    // thread is left where it is; a caller that wants it on the first CPU
+    // pins itself.
+    explicit Scheduler(int numThreads = static_cast<int>(std::thread::hardware_concurrency()), bool pin = false)
+        : pinned(pin), stopping(false), searching(0), sleeping(0), epoch(0) {
+        if (numThreads < 1) numThreads = 1;
+        for (int i = 0; i < numThreads; i++) workers.emplace_back(new Worker(12345u + 7919u * i));
+        ownerPrevious = detail::currentBinding();
+        detail::currentBinding() = {this, 0};
+        for (int i = 1; i < numThreads; i++) threads.emplace_back(&Scheduler::workerLoop, this, i);
+    }
+
+    ~Scheduler() {
+        stopping.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            epoch.fetch_add(1, std::memory_order_relaxed);
+        }
+        wakeUp.notify_all();
+        for (std::thread& t : threads) t.join();
+        detail::currentBinding() = ownerPrevious;
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()); }
+
+    // Index of the calling thread in the pool it is working for, -1 outside
+    // any pool. Handy for per-worker buffers.
+    static int workerIndex() { return detail::currentBinding().index; }
+
+    bool owns(const detail::Binding& binding) const { return binding.pool == this; }
+
+    // Slot of the calling thread in per-worker buffers of slots() entries:
+    // its worker index, or size() for a thread outside this pool, whose
+    // parallel loops and spawns run inline on it.
+    int slot() const {
+        const detail::Binding& binding = detail::currentBinding();
+        return owns(binding) ? binding.index : size();
+    }
+    int slots() const { return size() + 1; }
+
+    // A sleeping worker is only woken when no other is already searching:
+    // that one is bound to find the task, and waking costs a system call.
+    void push(Task* task) {
+        workers[detail::currentBinding().index]->deque.push(task);
+        if (workers.size() == 1) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (searching.load(std::memory_order_relaxed) == 0 && sleeping.load(std::memory_order_relaxed) > 0) {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                epoch.fetch_add(1, std::memory_order_relaxed);
+            }
+            wakeUp.notify_one();
+        }
+    }
+
+    // Runs one task on behalf of a thread waiting in sync(); false if there
+    // was none to be found.
+    bool helpOnce() {
+        Task* task = findTask(detail::currentBinding().index);
+        if (!task) return false;
+        execute(task);
+        return true;
+    }
+
+    // body(lo, hi) over [begin, end), in pieces of at most grain iterations.
+    // The range is halved recursively: the upper half is offered to thieves
+    // and the lower half kept, so the first steal takes half the loop.
+    template<typename F>
+    void parallelFor(long begin, long end, long grain, const F& body);
+};
+
+class TaskGroup {
+private:
+    Scheduler& pool;
+    std::atomic<long> pending;
+
+public:
+    explicit TaskGroup(Scheduler& scheduler) : pool(scheduler), pending(0) {}
+    ~TaskGroup() { sync(); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    template<typename F>
+    void spawn(F&& function) {
+        if (!pool.owns(detail::currentBinding())) {
+            function();
+            return;
+        }
+        Task* task = new FunctionTask<typename std::decay<F>::type>(std::forward<F>(function));
+        task->pending = &pending;
+        pending.fetch_add(1, std::memory_order_relaxed);
+        pool.push(task);
+    }
+
+    // Waits for every task spawned into this group, including those spawned
+    // by its tasks, running queued work in the meantime.
+    void sync() {
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (!pool.helpOnce()) std::this_thread::yield();
+        }
+    }
+};
+
+template<typename F>
+void Scheduler::parallelFor(long begin, long end, long grain, const F& body) {
+    if (grain < 1) grain = 1;
+    if (end - begin <= grain) {
+        if (begin < end) body(begin, end);
+        return;
+    }
+    TaskGroup group(*this);
+    while (end - begin > grain) {
+        long mid = begin + (end - begin) / 2;
+        group.spawn([this, mid, end, grain, &body] { parallelFor(mid, end, grain, body); });
+        end = mid;
+    }
+    body(begin, end);
+    group.sync();
+}
+
+} // namespace ws
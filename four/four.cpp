@@ -0,0 +1,593 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <iomanip>
+#include <algorithm>
+#include <unistd.h>
+#include <immintrin.h>
+#include <omp.h>
+#ifdef USE_CBLAS
+#include <cblas.h>
+#endif
+
+using namespace std;
+
+// CPU versions of the two practical four workloads (vector addition and
+// matrix multiplication), for machines without a GPU. The vector width and
+// the GEMM register tile are chosen at compile time from the instruction
+// set, so build with -march=native.
+#if defined(__AVX512F__)
+const char* SIMD_NAME = "AVX-512";
+const int VEC = 16;
+typedef __m512 vfloat;
+inline vfloat vload(const float* p) { return _mm512_load_ps(p); }
+inline vfloat vloadu(const float* p) { return _mm512_loadu_ps(p); }
+inline void vstoreu(float* p, vfloat v) { _mm512_storeu_ps(p, v); }
+inline void vstream(float* p, vfloat v) { _mm512_stream_ps(p, v); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm512_add_ps(a, b); }
+inline vfloat vfma(vfloat a, vfloat b, vfloat c) { return _mm512_fmadd_ps(a, b, c); }
+inline vfloat vbroadcast(float x) { return _mm512_set1_ps(x); }
+inline float vsum(vfloat v) {
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, v);
+    float s = 0.0f;
+    for (int i = 0; i < 16; i++) s += lanes[i];
+    return s;
+}
+const int MR = 12; // 12 x 2 accumulators + 2 B vectors + 1 broadcast of 32 zmm registers
+const int NR = 32;
+#elif defined(__AVX2__) && defined(__FMA__)
+const char* SIMD_NAME = "AVX2+FMA";
+const int VEC = 8;
+typedef __m256 vfloat;
+inline vfloat vload(const float* p) { return _mm256_load_ps(p); }
+inline vfloat vloadu(const float* p) { return _mm256_loadu_ps(p); }
+inline void vstoreu(float* p, vfloat v) { _mm256_storeu_ps(p, v); }
+inline void vstream(float* p, vfloat v) { _mm256_stream_ps(p, v); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+inline vfloat vfma(vfloat a, vfloat b, vfloat c) { return _mm256_fmadd_ps(a, b, c); }
+inline vfloat vbroadcast(float x) { return _mm256_set1_ps(x); }
+inline float vsum(vfloat v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_hadd_ps(s, s);
+    s = _mm_hadd_ps(s, s);
+    return _mm_cvtss_f32(s);
+}
+const int MR = 6; // 6 x 2 accumulators + 2 B vectors + 1 broadcast of 16 ymm registers
+const int NR = 16;
+#else
+const char* SIMD_NAME = "scalar";
+const int VEC = 1;
+typedef float vfloat;
+inline vfloat vload(const float* p) { return *p; }
+inline vfloat vloadu(const float* p) { return *p; }
+inline void vstoreu(float* p, vfloat v) { *p = v; }
+inline void vstream(float* p, vfloat v) { *p = v; }
+inline vfloat vadd(vfloat a, vfloat b) { return a + b; }
+inline vfloat vfma(vfloat a, vfloat b, vfloat c) { return a * b + c; }
+inline vfloat vbroadcast(float x) { return x; }
+inline float vsum(vfloat v) { return v; }
+const int MR = 4;
+const int NR = 4;
+#endif
+const int NR_VECS = NR / VEC;
+
+// 64-byte aligned float array: every SIMD load and non-temporal store on
+// it is aligned, and no two arrays share a cache line.
+class AlignedArray {
+private:
+    float* ptr;
+    size_t count;
+
+public:
+    explicit AlignedArray(size_t n) : ptr(nullptr), count(n) {
+        size_t bytes = max<size_t>(64, (n * sizeof(float) + 63) / 64 * 64);
+        ptr = static_cast<float*>(aligned_alloc(64, bytes));
+        if (ptr == nullptr) {
+            cerr << "Failed to allocate " << bytes << " bytes" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    ~AlignedArray() { free(ptr); }
+    AlignedArray(const AlignedArray&) = delete;
+    AlignedArray& operator=(const AlignedArray&) = delete;
+
+    float* data() { return ptr; }
+    const float* data() const { return ptr; }
+    size_t size() const { return count; }
+    float& operator[](size_t i) { return ptr[i]; }
+    const float& operator[](size_t i) const { return ptr[i]; }
+};
+
+template<typename Kernel>
+double bestTimeSeconds(Kernel kernel, int runs) {
+    double best = 1e30;
+    for (int r = 0; r < runs; r++) {
+        auto start = chrono::high_resolution_clock::now();
+        kernel();
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+// Measured ceilings for the roofline comparison. Compute: every thread
+// runs independent FMA chains that never touch memory, enough of them to
+// hide the FMA latency on both ports. Memory: every thread streams
+// through its share of a large array with a vectorised read-only sum.
+class MachinePeak {
+public:
+    double gflops = 0.0;
+    double readGBs = 0.0;
+    double copyGBs = 0.0;
+
+    void measure(size_t bandwidthElements) {
+        const long iterations = 20000000;
+        const int chains = 12;
+        double seconds = bestTimeSeconds([&]() {
+            #pragma omp parallel
+            {
+                vfloat acc[chains];
+                for (int j = 0; j < chains; j++) acc[j] = vbroadcast(1.0f + j);
+                vfloat scale = vbroadcast(0.999999f);
+                vfloat shift = vbroadcast(1e-7f);
+                for (long it = 0; it < iterations / (VEC * chains); it++) {
+                    for (int j = 0; j < chains; j++) acc[j] = vfma(acc[j], scale, shift);
+                }
+                float total = 0.0f;
+                for (int j = 0; j < chains; j++) total += vsum(acc[j]);
+                volatile float keep = total;  // keeps the chains live
+                (void)keep;
+            }
+        }, 3);
+        long flopsPerThread = (iterations / (VEC * chains)) * VEC * chains * 2;
+        gflops = flopsPerThread * omp_get_max_threads() / seconds / 1e9;
+
+        AlignedArray data(bandwidthElements);
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < bandwidthElements; i++) data[i] = 1.0f;
+        volatile float sink = 0.0f;
+        seconds = bestTimeSeconds([&]() {
+            float total = 0.0f;
+            #pragma omp parallel reduction(+:total)
+            {
+                int threads = omp_get_num_threads();
+                int t = omp_get_thread_num();
+                size_t vectors = bandwidthElements / VEC;
+                size_t begin = vectors * t / threads * VEC;
+                size_t end = vectors * (t + 1) / threads * VEC;
+                vfloat s0 = vbroadcast(0.0f), s1 = s0, s2 = s0, s3 = s0;
+                size_t i = begin;
+                for (; i + 4 * VEC <= end; i += 4 * VEC) {
+                    s0 = vadd(s0, vload(data.data() + i));
+                    s1 = vadd(s1, vload(data.data() + i + VEC));
+                    s2 = vadd(s2, vload(data.data() + i + 2 * VEC));
+                    s3 = vadd(s3, vload(data.data() + i + 3 * VEC));
+                }
+                for (; i < end; i += VEC) s0 = vadd(s0, vload(data.data() + i));
+                total += vsum(vadd(vadd(s0, s1), vadd(s2, s3)));
+            }
+            sink = total;
+        }, 5);
+        readGBs = bandwidthElements * sizeof(float) / seconds / 1e9;
+
+        // A copy with non-temporal stores: the ceiling for kernels that
+        // write as much as they read, where the read-only figure alone
+        // understates what the memory system delivers.
+        AlignedArray target(bandwidthElements);
+        seconds = bestTimeSeconds([&]() {
+            #pragma omp parallel
+            {
+                int threads = omp_get_num_threads();
+                int t = omp_get_thread_num();
+                size_t vectors = bandwidthElements / VEC;
+                size_t begin = vectors * t / threads * VEC;
+                size_t end = vectors * (t + 1) / threads * VEC;
+                for (size_t i = begin; i < end; i += VEC) vstream(target.data() + i, vload(data.data() + i));
+            }
+            _mm_sfence();
+        }, 5);
+        copyGBs = 2 * bandwidthElements * sizeof(float) / seconds / 1e9;
+    }
+};
+
+class VectorAdd {
+private:
+    size_t n;
+    AlignedArray a, b, c;
+
+public:
+    // Initialised in parallel so every page is first touched by the thread
+    // that will stream it.
+    explicit VectorAdd(size_t size) : n(size), a(size), b(size), c(size) {
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; i++) {
+            a[i] = static_cast<float>(i);
+            b[i] = static_cast<float>(i) * 2.0f;
+            c[i] = 0.0f;
+        }
+    }
+
+    // Plain loop: the compiler vectorises it, but every store first reads
+    // its cache line (write-allocate), so 16 bytes move per element.
+    void addRegular() {
+        float* pa = a.data();
+        float* pb = b.data();
+        float* pc = c.data();
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; i++) {
+            pc[i] = pa[i] + pb[i];
+        }
+    }
+
+    // Non-temporal stores write c straight to memory without reading or
+    // caching it: 12 bytes per element, and a and b keep the cache. Each
+    // thread's range starts on a vector boundary, so every access is
+    // aligned; the last thread finishes the scalar tail.
+    void addStreaming() {
+        const float* pa = a.data();
+        const float* pb = b.data();
+        float* pc = c.data();
+        #pragma omp parallel
+        {
+            int threads = omp_get_num_threads();
+            int t = omp_get_thread_num();
+            size_t vectors = n / VEC;
+            size_t begin = vectors * t / threads * VEC;
+            size_t end = vectors * (t + 1) / threads * VEC;
+            for (size_t i = begin; i < end; i += VEC) {
+                vstream(pc + i, vadd(vload(pa + i), vload(pb + i)));
+            }
+            if (t == threads - 1) {
+                for (size_t i = vectors * VEC; i < n; i++) pc[i] = pa[i] + pb[i];
+            }
+            _mm_sfence();
+        }
+    }
+
+    bool verify() {
+        for (size_t i = 0; i < n; i++) {
+            if (c[i] != a[i] + b[i]) return false;
+        }
+        return true;
+    }
+
+    void runBenchmark(const MachinePeak& peak, int runs) {
+        double bytes = 3.0 * n * sizeof(float);
+        cout << "Vector Addition (CPU, " << SIMD_NAME << ")" << endl;
+        cout << "Vector size: " << n << " elements (" << fixed << setprecision(2)
+             << n * sizeof(float) / (1024.0 * 1024.0) << " MB per vector)" << endl;
+
+        double regular = bestTimeSeconds([&]() { addRegular(); }, runs);
+        bool regularOk = verify();
+        fill(c.data(), c.data() + n, 0.0f);
+        double streaming = bestTimeSeconds([&]() { addStreaming(); }, runs);
+        bool streamingOk = verify();
+
+        cout << "Regular stores:       " << setprecision(3) << regular * 1000 << " ms, " << setprecision(2)
+             << bytes / regular / 1e9 << " GB/s (" << 100.0 * bytes / regular / 1e9 / peak.copyGBs
+             << "% of copy peak)" << (regularOk ? "" : "  FAILED") << endl;
+        cout << "Non-temporal stores:  " << setprecision(3) << streaming * 1000 << " ms, " << setprecision(2)
+             << bytes / streaming / 1e9 << " GB/s (" << 100.0 * bytes / streaming / 1e9 / peak.copyGBs
+             << "% of copy peak)" << (streamingOk ? "" : "  FAILED") << endl;
+        cout << "Verification: " << (regularOk && streamingOk ? "Successful!" : "FAILED!") << endl;
+    }
+};
+
+// C = A * B for row-major single-precision matrices (A is M x K, B is
+// K x N), blocked the way BLIS does it:
+//   jc: NC-wide column panels of B, sized so a packed KC x NC panel stays in L3
+//   pc: KC-deep slices; the panel of B is packed once per slice, by all threads
+//   ic: MC-tall row blocks of A, packed per thread so the block stays in L2;
+//       the OpenMP loop runs over these macro-tiles
+//   jr, ir: NR x MR micro-tiles; one KC x NR sliver of B stays in L1
+//   microkernel: an MR x NR tile of C in registers, KC rank-1 FMA updates
+// Packing lays both operands out in the exact order the microkernel reads
+// them, so its loads are unit-stride and aligned. Fringe slivers are
+// zero-padded, so the microkernel never needs a bounds check.
+class BlockedGemm {
+private:
+    int MC, KC, NC;
+
+    static long cacheSize(int name, long fallback) {
+        long size = sysconf(name);
+        return size > 0 ? size : fallback;
+    }
+
+    static int roundDown(long value, int multiple, int minimum, int maximum) {
+        long v = max<long>(minimum, min<long>(maximum, value));
+        return static_cast<int>(max<long>(multiple, v / multiple * multiple));
+    }
+
+    // Packs rows [0, mc) x depth [0, kc) of A into MR-row slivers, each
+    // stored k-major: MR values of column k, then MR of column k + 1, ...
+    static void packA(const float* A, int lda, int mc, int kc, float* Ap) {
+        for (int i0 = 0; i0 < mc; i0 += MR) {
+            int rows = min(MR, mc - i0);
+            for (int k = 0; k < kc; k++) {
+                for (int i = 0; i < rows; i++) Ap[i] = A[(size_t)(i0 + i) * lda + k];
+                for (int i = rows; i < MR; i++) Ap[i] = 0.0f;
+                Ap += MR;
+            }
+        }
+    }
+
+    // Packs depth [0, kc) x columns [0, nc) of B into NR-column slivers,
+    // each stored row by row. Slivers are independent, so all threads share
+    // the work.
+    static void packB(const float* B, int ldb, int kc, int nc, float* Bp) {
+        int slivers = (nc + NR - 1) / NR;
+        #pragma omp for schedule(static)
+        for (int s = 0; s < slivers; s++) {
+            int j0 = s * NR;
+            int cols = min(NR, nc - j0);
+            float* dst = Bp + (size_t)s * kc * NR;
+            for (int k = 0; k < kc; k++) {
+                const float* src = B + (size_t)k * ldb + j0;
+                for (int j = 0; j < cols; j++) dst[j] = src[j];
+                for (int j = cols; j < NR; j++) dst[j] = 0.0f;
+                dst += NR;
+            }
+        }
+    }
+
+    // C[0:MR, 0:NR] (+)= Ap * Bp over kc steps. The MR x NR_VECS
+    // accumulators are fixed-size arrays the compiler keeps in registers.
+    static void microKernel(int kc, const float* Ap, const float* Bp, float* C, int ldc, bool accumulate) {
+        // The C tile is only needed after the loop: start fetching it now.
+        for (int i = 0; i < MR; i++) {
+            _mm_prefetch(reinterpret_cast<const char*>(C + (size_t)i * ldc), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(C + (size_t)i * ldc + NR - 1), _MM_HINT_T0);
+        }
+        vfloat acc[MR][NR_VECS];
+        for (int i = 0; i < MR; i++)
+            for (int j = 0; j < NR_VECS; j++) acc[i][j] = vbroadcast(0.0f);
+
+        for (int k = 0; k < kc; k++) {
+            vfloat b[NR_VECS];
+            for (int j = 0; j < NR_VECS; j++) b[j] = vload(Bp + j * VEC);
+            for (int i = 0; i < MR; i++) {
+                vfloat a = vbroadcast(Ap[i]);
+                for (int j = 0; j < NR_VECS; j++) acc[i][j] = vfma(a, b[j], acc[i][j]);
+            }
+            Ap += MR;
+            Bp += NR;
+        }
+
+        for (int i = 0; i < MR; i++) {
+            for (int j = 0; j < NR_VECS; j++) {
+                float* c = C + (size_t)i * ldc + j * VEC;
+                vstoreu(c, accumulate ? vadd(acc[i][j], vloadu(c)) : acc[i][j]);
+            }
+        }
+    }
+
+    // Fringe tiles (mr < MR or nr < NR) run the same kernel on an aligned
+    // scratch tile and copy the valid part.
+    static void edgeKernel(int kc, const float* Ap, const float* Bp, float* C, int ldc, int mr, int nr,
+                           bool accumulate) {
+        alignas(64) float tile[MR * NR];
+        microKernel(kc, Ap, Bp, tile, NR, false);
+        for (int i = 0; i < mr; i++) {
+            for (int j = 0; j < nr; j++) {
+                float& c = C[(size_t)i * ldc + j];
+                c = accumulate ? c + tile[i * NR + j] : tile[i * NR + j];
+            }
+        }
+    }
+
+public:
+    // Block sizes from the cache hierarchy: a KC x NR sliver of B fills
+    // L1 (the A sliver is streamed and only needs a few lines), an MC x KC
+    // block of A a quarter of L2, a KC x NC panel of B half of L3 (capped,
+    // since L3 is shared and often reported generously). A deep KC matters
+    // most: it is the number of FMAs between two passes over the C tile.
+    BlockedGemm() {
+        long l1 = cacheSize(_SC_LEVEL1_DCACHE_SIZE, 32 * 1024);
+        long l2 = cacheSize(_SC_LEVEL2_CACHE_SIZE, 1024 * 1024);
+        long l3 = cacheSize(_SC_LEVEL3_CACHE_SIZE, 8 * 1024 * 1024);
+        KC = roundDown(l1 / (NR * sizeof(float)), 8, 64, 512);
+        MC = roundDown(l2 / 4 / (KC * sizeof(float)), MR, MR, 480);
+        NC = roundDown(l3 / 2 / (KC * sizeof(float)), NR, NR, 4096);
+    }
+
+    string describe() const {
+        return "MR x NR = " + to_string(MR) + " x " + to_string(NR) + ", MC = " + to_string(MC) +
+               ", KC = " + to_string(KC) + ", NC = " + to_string(NC);
+    }
+
+    void multiply(const float* A, const float* B, float* C, int M, int N, int K) {
+        if (M == 0 || N == 0) return;
+        if (K == 0) {
+            fill(C, C + (size_t)M * N, 0.0f);
+            return;
+        }
+        int threads = omp_get_max_threads();
+        // Enough macro-tiles for every thread when M is small.
+        int mc = min(MC, max(MR, ((M + threads - 1) / threads + MR - 1) / MR * MR));
+        int nc = min(NC, (N + NR - 1) / NR * NR);
+        int kcMax = min(KC, K);
+        AlignedArray Bp((size_t)kcMax * nc);
+
+        #pragma omp parallel
+        {
+            AlignedArray Ap((size_t)mc * kcMax);
+            for (int jc = 0; jc < N; jc += nc) {
+                int ncCur = min(nc, N - jc);
+                for (int pc = 0; pc < K; pc += KC) {
+                    int kc = min(KC, K - pc);
+                    bool accumulate = pc > 0;
+                    packB(B + (size_t)pc * N + jc, N, kc, ncCur, Bp.data()); // ends with a barrier
+
+                    #pragma omp for schedule(dynamic)
+                    for (int ic = 0; ic < M; ic += mc) {
+                        int mcCur = min(mc, M - ic);
+                        packA(A + (size_t)ic * K + pc, K, mcCur, kc, Ap.data());
+                        for (int jr = 0; jr < ncCur; jr += NR) {
+                            int nr = min(NR, ncCur - jr);
+                            const float* Bs = Bp.data() + (size_t)(jr / NR) * kc * NR;
+                            for (int ir = 0; ir < mcCur; ir += MR) {
+                                int mr = min(MR, mcCur - ir);
+                                const float* As = Ap.data() + (size_t)(ir / MR) * kc * MR;
+                                float* Cs = C + (size_t)(ic + ir) * N + jc + jr;
+                                if (mr == MR && nr == NR) {
+                                    microKernel(kc, As, Bs, Cs, N, accumulate);
+                                } else {
+                                    edgeKernel(kc, As, Bs, Cs, N, mr, nr, accumulate);
+                                }
+                            }
+                        }
+                    } // implicit barrier: Bp is not repacked while in use
+                }
+            }
+        }
+    }
+};
+
+// Scalar reference for checking: one dot product per entry of C, in
+// double precision.
+double referenceEntry(const float* A, const float* B, int N, int K, int i, int j) {
+    double sum = 0.0;
+    for (int k = 0; k < K; k++) sum += (double)A[(size_t)i * K + k] * B[(size_t)k * N + j];
+    return sum;
+}
+
+class MatrixMultiply {
+private:
+    int M, N, K;
+    AlignedArray A, B, C;
+
+    // Small products are checked entry by entry; larger ones on a random
+    // sample of entries, each against the scalar reference.
+    bool verify() {
+        long entries = (long)M * N;
+        long checks = (long)M * N * K <= (1L << 27) ? entries : 4096;
+        mt19937 gen(7);
+        uniform_int_distribution<long> pick(0, entries - 1);
+        double worst = 0.0;
+        for (long c = 0; c < checks; c++) {
+            long e = checks == entries ? c : pick(gen);
+            int i = e / N, j = e % N;
+            double expected = referenceEntry(A.data(), B.data(), N, K, i, j);
+            // Inputs are in [-1, 1]: the float rounding error grows with sqrt(K).
+            double error = fabs(C[e] - expected) / (1.0 + sqrt((double)K));
+            worst = max(worst, error);
+        }
+        return worst < 1e-4;
+    }
+
+public:
+    MatrixMultiply(int m, int n, int k) : M(m), N(n), K(k), A((size_t)m * k), B((size_t)k * n), C((size_t)m * n) {
+        mt19937 gen(42);
+        uniform_real_distribution<float> distrib(-1.0f, 1.0f);
+        for (size_t i = 0; i < A.size(); i++) A[i] = distrib(gen);
+        for (size_t i = 0; i < B.size(); i++) B[i] = distrib(gen);
+    }
+
+    void runBenchmark(BlockedGemm& gemm, const MachinePeak& peak, int runs) {
+        double flops = 2.0 * M * N * K;
+        // Compulsory traffic: A and B read once, C written once.
+        double bytes = ((double)M * K + (double)K * N + (double)M * N) * sizeof(float);
+
+        double blocked = bestTimeSeconds([&]() { gemm.multiply(A.data(), B.data(), C.data(), M, N, K); }, runs);
+        bool ok = verify();
+        double gflops = flops / blocked / 1e9;
+
+        cout << setw(5) << M << " x " << setw(5) << N << " x " << setw(5) << K << "  " << fixed
+             << setprecision(3) << setw(9) << blocked * 1000 << " ms  " << setprecision(1) << setw(7) << gflops
+             << " GFLOP/s (" << setw(5) << 100.0 * gflops / peak.gflops << "% peak)  " << setprecision(1) << setw(7)
+             << bytes / blocked / 1e9 << " GB/s";
+#ifdef USE_CBLAS
+        double blas = bestTimeSeconds([&]() {
+            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, M, N, K, 1.0f, A.data(), K, B.data(), N, 0.0f,
+                        C.data(), N);
+        }, runs);
+        cout << "  BLAS " << setw(7) << flops / blas / 1e9 << " GFLOP/s (" << setprecision(2)
+             << blas / blocked << "x)";
+#endif
+        cout << (ok ? "  verified" : "  FAILED") << endl;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    size_t vectorSize = 1 << 25;
+    vector<vector<int>> shapes = {{512, 512, 512}, {1024, 1024, 1024}, {2048, 2048, 2048},
+                                  {4096, 4096, 256}, {256, 4096, 4096}, {4096, 256, 4096}};
+    bool customShapes = false;
+    int runs = 5;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--vector" && hasValue) {
+            vectorSize = atoll(argv[++i]);
+        } else if (arg == "--shape" && hasValue) {
+            int m, n, k;
+            if (sscanf(argv[++i], "%dx%dx%d", &m, &n, &k) == 3 && m > 0 && n > 0 && k > 0) {
+                if (!customShapes) shapes.clear();
+                customShapes = true;
+                shapes.push_back({m, n, k});
+            } else {
+                cerr << "Shape must be MxNxK with positive sizes, e.g. 1024x1024x1024" << endl;
+            }
+        } else if (arg == "--threads" && hasValue) {
+            omp_set_num_threads(max(1, atoi(argv[++i])));
+        } else if (arg == "--runs" && hasValue) {
+            runs = max(1, atoi(argv[++i]));
+        }
+    }
+
+    MachinePeak peak;
+    peak.measure(vectorSize);
+    cout << "Threads: " << omp_get_max_threads() << ", SIMD: " << SIMD_NAME << endl;
+    cout << "Measured peak: " << fixed << setprecision(1) << peak.gflops << " GFLOP/s (FMA), "
+         << peak.readGBs << " GB/s (read), " << peak.copyGBs
+         << " GB/s (non-temporal copy)" << endl;
+    cout << "------------------------------------------------------------" << endl;
+
+    VectorAdd vectorAdd(vectorSize);
+    vectorAdd.runBenchmark(peak, runs);
+    cout << "------------------------------------------------------------" << endl;
+
+    BlockedGemm gemm;
+    cout << "Matrix Multiplication (CPU, " << SIMD_NAME << ", " << gemm.describe() << ")" << endl;
+    cout << "    M x     N x     K" << endl;
+    for (const vector<int>& s : shapes) {
+        MatrixMultiply mm(s[0], s[1], s[2]);
+        mm.runBenchmark(gemm, peak, runs);
+    }
+
+    return 0;
+}
+
+/*
+Command -> g++ -O3 -march=native -fopenmp four.cpp -o four && ./four
+With vendor BLAS -> g++ -O3 -march=native -fopenmp -DUSE_CBLAS four.cpp -o four -lopenblas && ./four
+One shape -> ./four --shape 3000x2000x1000 --threads 8
+
+--------------------------------------
+Output (1 core, AVX-512, OpenBLAS with OPENBLAS_CORETYPE=SkylakeX)
+--------------------------------------
+Threads: 1, SIMD: AVX-512
+Measured peak: 165.3 GFLOP/s (FMA), 12.3 GB/s (read), 15.5 GB/s (non-temporal copy)
+------------------------------------------------------------
+Vector Addition (CPU, AVX-512)
+Vector size: 33554432 elements (128.00 MB per vector)
+Regular stores:       33.327 ms, 12.08 GB/s (77.81% of copy peak)
+Non-temporal stores:  24.708 ms, 16.30 GB/s (104.95% of copy peak)
+Verification: Successful!
+------------------------------------------------------------
+Matrix Multiplication (CPU, AVX-512, MR x NR = 12 x 32, MC = 336, KC = 384, NC = 4096)
+    M x     N x     K
+  512 x   512 x   512      2.905 ms     92.4 GFLOP/s ( 55.9% peak)      1.1 GB/s  BLAS    97.1 GFLOP/s (0.95x)  verified
+ 1024 x  1024 x  1024     16.750 ms    128.2 GFLOP/s ( 77.6% peak)      0.8 GB/s  BLAS   124.4 GFLOP/s (1.03x)  verified
+ 2048 x  2048 x  2048    147.411 ms    116.5 GFLOP/s ( 70.5% peak)      0.3 GB/s  BLAS   136.0 GFLOP/s (0.86x)  verified
+ 4096 x  4096 x   256     71.011 ms    121.0 GFLOP/s ( 73.2% peak)      1.1 GB/s  BLAS   122.2 GFLOP/s (0.99x)  verified
+  256 x  4096 x  4096     84.611 ms    101.5 GFLOP/s ( 61.4% peak)      0.9 GB/s  BLAS   113.8 GFLOP/s (0.89x)  verified
+ 4096 x   256 x  4096     78.204 ms    109.8 GFLOP/s ( 66.4% peak)      1.0 GB/s  BLAS   108.0 GFLOP/s (1.02x)  verified
+
+*/
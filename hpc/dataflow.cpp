@@ -0,0 +1,117 @@
+#include "dataflow.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "../common/pipeline.h"
+
+using namespace std;
+
+vector<int> DataflowJob::generateChunk(long long index) const {
+    vector<int> chunk(config.chunkSize);
+    mt19937 gen(config.seed + static_cast<unsigned>(index));
+    uniform_int_distribution<> distrib(config.minValue, config.maxValue);
+    for (int& v : chunk) v = distrib(gen);
+    return chunk;
+}
+
+// The run is sorted, so its extremes are its ends; walking it for the sum
+// also confirms the order.
+void DataflowJob::reduceRun(const vector<int>& run, DataflowResult& result) {
+    if (run.empty()) return;
+    long long sum = run[0];
+    bool sorted = true;
+    for (size_t i = 1; i < run.size(); i++) {
+        sum += run[i];
+        sorted = sorted && run[i - 1] <= run[i];
+    }
+    result.count += run.size();
+    result.sum += sum;
+    result.min = min<long long>(result.min, run.front());
+    result.max = max<long long>(result.max, run.back());
+    if (sorted) result.sortedRuns++;
+}
+
+DataflowResult DataflowJob::runStaged() {
+    DataflowResult result;
+    auto start = chrono::steady_clock::now();
+    auto mark = start;
+    auto lap = [&](const string& name) {
+        auto now = chrono::steady_clock::now();
+        result.stageSeconds.push_back(make_pair(name, chrono::duration<double>(now - mark).count()));
+        mark = now;
+    };
+
+    vector<vector<int>> data(config.chunks);
+    for (long long i = 0; i < config.chunks; i++) data[i] = generateChunk(i);
+    lap("generate");
+
+    atomic<long long> next(0);
+    vector<thread> sorters;
+    for (int t = 0; t < config.sortThreads; t++) {
+        sorters.emplace_back([&] {
+            for (long long i = next.fetch_add(1); i < config.chunks; i = next.fetch_add(1)) {
+                sort(data[i].begin(), data[i].end());
+            }
+        });
+    }
+    for (thread& t : sorters) t.join();
+    lap("sort");
+
+    for (const vector<int>& run : data) reduceRun(run, result);
+    lap("reduce");
+
+    result.peakChunks = config.chunks;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+DataflowResult DataflowJob::runStreamed(ostream* report) {
+    DataflowResult result;
+    typedef vector<int> Chunk;
+    pipeline::Channel<Chunk> generated(config.capacity, 1, config.sortThreads);
+    pipeline::Channel<Chunk> sorted(config.capacity, config.sortThreads, 1);
+    atomic<long long> alive(0);
+    atomic<long long> peak(0);
+    const long long chunkBytes = config.chunkSize * sizeof(int);
+
+    pipeline::Pipeline p;
+    p.stage("generate", 1, [&](int, pipeline::StageStats& stats) {
+        for (long long i = 0; i < config.chunks; i++) {
+            Chunk chunk = generateChunk(i);
+            long long now = alive.fetch_add(1) + 1;
+            long long seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            stats.add(1, chunkBytes);
+            generated.push(move(chunk), stats);
+        }
+        generated.close();
+    });
+    p.stage("sort", config.sortThreads, [&](int, pipeline::StageStats& stats) {
+        Chunk chunk;
+        while (generated.pop(chunk, stats)) {
+            sort(chunk.begin(), chunk.end());
+            stats.add(1, chunkBytes);
+            sorted.push(move(chunk), stats);
+        }
+        sorted.close();
+    });
+    p.stage("reduce", 1, [&](int, pipeline::StageStats& stats) {
+        Chunk run;
+        while (sorted.pop(run, stats)) {
+            reduceRun(run, result);
+            stats.add(1, chunkBytes);
+            run = Chunk();
+            alive.fetch_sub(1);
+        }
+    });
+    p.run();
+
+    result.peakChunks = peak.load();
+    result.seconds = p.seconds();
+    if (report) p.report(*report);
+    return result;
+}
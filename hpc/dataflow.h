@@ -0,0 +1,64 @@
+// The nightly generate -> sort -> reduce job of practicals two and three,
+// over a stream of chunks of random integers: each chunk is sorted into a
+// run and the runs are reduced to count, min, max, sum and average.
+//
+// runStaged() is the batch way: every stage materializes the whole dataset
+// and the next starts when it is done, so the job takes the sum of the
+// stages. runStreamed() puts the stages on their own threads joined by
+// bounded channels, so chunks flow through as they are produced, at most a
+// few chunks are alive at once, and the job takes about as long as its
+// slowest stage. Chunk i is generated from seed + i in both, so the two
+// must agree exactly.
+#pragma once
+
+#include <climits>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct DataflowConfig {
+    long long chunks = 256;
+    long long chunkSize = 1 << 16;
+    int sortThreads = 2;
+    int capacity = 4;  // chunks each channel holds
+    unsigned seed = 12345;
+    int minValue = -10000;
+    int maxValue = 10000;
+};
+
+struct DataflowResult {
+    long long count = 0;
+    long long min = LLONG_MAX;
+    long long max = LLONG_MIN;
+    long long sum = 0;
+    long long sortedRuns = 0;  // runs the reduce stage found in order
+    long long peakChunks = 0;  // chunks alive at once
+    double seconds = 0.0;
+    std::vector<std::pair<std::string, double>> stageSeconds;  // staged only
+
+    double average() const { return count ? static_cast<double>(sum) / count : 0.0; }
+    bool sameStatistics(const DataflowResult& other) const {
+        return count == other.count && min == other.min && max == other.max && sum == other.sum;
+    }
+};
+
+class DataflowJob {
+private:
+    DataflowConfig config;
+
+    std::vector<int> generateChunk(long long index) const;
+    static void reduceRun(const std::vector<int>& run, DataflowResult& result);
+
+public:
+    explicit DataflowJob(const DataflowConfig& cfg) : config(cfg) {}
+
+    const DataflowConfig& settings() const { return config; }
+    double datasetBytes() const { return static_cast<double>(config.chunks) * config.chunkSize * sizeof(int); }
+
+    DataflowResult runStaged();
+
+    // With report set, the per-stage throughput and wait breakdown of the
+    // pipeline is printed there.
+    DataflowResult runStreamed(std::ostream* report = nullptr);
+};
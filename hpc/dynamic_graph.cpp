@@ -0,0 +1,322 @@
+#include "dynamic_graph.h"
+
+#include <algorithm>
+#include <queue>
+
+using namespace std;
+
+DynamicGraph::DynamicGraph(long long numVertices, const vector<long long>& rootVertices)
+    : vertices(numVertices), roots(rootVertices), head(numVertices, -1), degrees(numVertices, 0),
+      distances(numVertices), marked(numVertices) {
+    for (long long v = 0; v < vertices; v++) distances[v].store(UNREACHED, memory_order_relaxed);
+    for (long long root : roots) distances[root].store(0, memory_order_relaxed);
+}
+
+long long DynamicGraph::reached() const {
+    long long count = 0;
+    for (long long v = 0; v < vertices; v++) {
+        if (distance(v) != UNREACHED) count++;
+    }
+    return count;
+}
+
+// Both directions of every edge, grouped by source vertex so that one task
+// owns all the changes to a vertex's blocks. Self-loops never change a
+// distance and are dropped.
+vector<DynamicGraph::Edge> DynamicGraph::directed(const vector<Edge>& batch) {
+    vector<Edge> entries;
+    entries.reserve(2 * batch.size());
+    for (const Edge& e : batch) {
+        if (e.v == e.w) continue;
+        entries.push_back({e.v, e.w});
+        entries.push_back({e.w, e.v});
+    }
+    sort(entries.begin(), entries.end(), [](const Edge& a, const Edge& b) {
+        return a.v < b.v || (a.v == b.v && a.w < b.w);
+    });
+    return entries;
+}
+
+static vector<size_t> groupStarts(const vector<DynamicGraph::Edge>& entries) {
+    vector<size_t> starts;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (i == 0 || entries[i].v != entries[i - 1].v) starts.push_back(i);
+    }
+    starts.push_back(entries.size());
+    return starts;
+}
+
+// Overwrites w's entry with the last one of the head block, so the blocks
+// behind the head stay full; an emptied head block is handed back.
+bool DynamicGraph::removeEntry(long long v, long long w, vector<int>& freed) {
+    for (int b = head[v]; b >= 0; b = blocks[b].next) {
+        Block& block = blocks[b];
+        for (int i = 0; i < block.count; i++) {
+            if (block.neighbors[i] != w) continue;
+            Block& first = blocks[head[v]];
+            block.neighbors[i] = first.neighbors[first.count - 1];
+            first.count--;
+            degrees[v]--;
+            if (first.count == 0) {
+                freed.push_back(head[v]);
+                head[v] = first.next;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+long long DynamicGraph::deleteEntries(ws::Scheduler& pool, const vector<Edge>& entries) {
+    vector<size_t> starts = groupStarts(entries);
+    vector<vector<int>> freed(pool.slots());
+    atomic<long long> removed(0);
+
+    pool.parallelFor(0, starts.size() - 1, UPDATE_GRAIN, [&](long lo, long hi) {
+        vector<int>& local_freed = freed[pool.slot()];
+        long long local_removed = 0;
+        for (long g = lo; g < hi; g++) {
+            for (size_t i = starts[g]; i < starts[g + 1]; i++) {
+                if (removeEntry(entries[i].v, entries[i].w, local_freed)) local_removed++;
+            }
+        }
+        removed.fetch_add(local_removed, memory_order_relaxed);
+    });
+
+    for (vector<int>& local_freed : freed) freeBlocks.insert(freeBlocks.end(), local_freed.begin(), local_freed.end());
+    return removed.load();
+}
+
+// Blocks are handed out serially, recycled ones first, and the block array
+// grows at most once per batch; then every vertex fills its own in parallel.
+void DynamicGraph::insertEntries(ws::Scheduler& pool, const vector<Edge>& entries) {
+    vector<size_t> starts = groupStarts(entries);
+    size_t groups = starts.size() - 1;
+    vector<size_t> firstAssigned(groups + 1, 0);
+    vector<int> assigned;
+    int fresh = 0;
+    int existing = static_cast<int>(blocks.size());
+
+    for (size_t g = 0; g < groups; g++) {
+        long long v = entries[starts[g]].v;
+        long long k = starts[g + 1] - starts[g];
+        long long room = head[v] >= 0 ? BLOCK_EDGES - blocks[head[v]].count : 0;
+        long long needed = k > room ? (k - room + BLOCK_EDGES - 1) / BLOCK_EDGES : 0;
+        firstAssigned[g] = assigned.size();
+        for (long long b = 0; b < needed; b++) {
+            if (!freeBlocks.empty()) {
+                assigned.push_back(freeBlocks.back());
+                freeBlocks.pop_back();
+            } else {
+                assigned.push_back(existing + fresh++);
+            }
+        }
+    }
+    firstAssigned[groups] = assigned.size();
+    blocks.resize(existing + fresh);
+
+    pool.parallelFor(0, groups, UPDATE_GRAIN, [&](long lo, long hi) {
+        for (long g = lo; g < hi; g++) {
+            long long v = entries[starts[g]].v;
+            size_t i = starts[g];
+            size_t end = starts[g + 1];
+            degrees[v] += end - i;
+            if (head[v] >= 0) {
+                Block& block = blocks[head[v]];
+                while (block.count < BLOCK_EDGES && i < end) block.neighbors[block.count++] = entries[i++].w;
+            }
+            for (size_t a = firstAssigned[g]; a < firstAssigned[g + 1]; a++) {
+                Block& block = blocks[assigned[a]];
+                block.count = 0;
+                block.next = head[v];
+                head[v] = assigned[a];
+                while (block.count < BLOCK_EDGES && i < end) block.neighbors[block.count++] = entries[i++].w;
+            }
+        }
+    });
+}
+
+// A vertex at distance d keeps its label while some neighbour is still at
+// d - 1. The endpoints of deleted tree edges are checked first; a vertex
+// that lost its last such neighbour is reset, which in turn puts its
+// neighbours at d + 1 in question. Levels are settled in increasing order,
+// so every check sees a final level d - 1, and vertices of one level are
+// checked in parallel since none can support another.
+vector<long long> DynamicGraph::invalidate(ws::Scheduler& pool, const vector<Edge>& deleted, UpdateStats& stats) {
+    map<long long, vector<long long>> candidates;
+    vector<long long> touched;
+    for (const Edge& e : deleted) {
+        long long dv = distance(e.v);
+        long long dw = distance(e.w);
+        if (dv == UNREACHED || dw != dv + 1) continue;
+        if (!marked[e.w].exchange(true, memory_order_relaxed)) {
+            candidates[dw].push_back(e.w);
+            touched.push_back(e.w);
+        }
+    }
+
+    vector<long long> invalid;
+    vector<vector<long long>> localNext(pool.slots());
+    vector<vector<long long>> localInvalid(pool.slots());
+    while (!candidates.empty()) {
+        long long d = candidates.begin()->first;
+        vector<long long> level = move(candidates.begin()->second);
+        candidates.erase(candidates.begin());
+
+        pool.parallelFor(0, level.size(), LEVEL_GRAIN, [&](long lo, long hi) {
+            int self = pool.slot();
+            for (long i = lo; i < hi; i++) {
+                long long w = level[i];
+                bool supported = false;
+                forEachNeighbor(w, [&](long long x) {
+                    if (distance(x) == d - 1) supported = true;
+                });
+                if (supported) continue;
+                distances[w].store(UNREACHED, memory_order_relaxed);
+                localInvalid[self].push_back(w);
+                forEachNeighbor(w, [&](long long y) {
+                    if (distance(y) == d + 1 && !marked[y].exchange(true, memory_order_relaxed)) {
+                        localNext[self].push_back(y);
+                    }
+                });
+            }
+        });
+
+        for (int t = 0; t < pool.slots(); t++) {
+            invalid.insert(invalid.end(), localInvalid[t].begin(), localInvalid[t].end());
+            localInvalid[t].clear();
+            if (localNext[t].empty()) continue;
+            vector<long long>& next = candidates[d + 1];
+            next.insert(next.end(), localNext[t].begin(), localNext[t].end());
+            touched.insert(touched.end(), localNext[t].begin(), localNext[t].end());
+            localNext[t].clear();
+        }
+    }
+
+    for (long long v : touched) marked[v].store(false, memory_order_relaxed);
+    stats.invalidated = invalid.size();
+    stats.touched += touched.size();
+    return invalid;
+}
+
+// Decrease-only BFS from labelled seeds, one bucket per distance and the
+// buckets in increasing order, so a vertex is final when its bucket comes
+// up. Within a bucket neighbours are lowered with a compare-and-swap, and
+// only the thread that lowered a vertex queues it.
+void DynamicGraph::relax(ws::Scheduler& pool, map<long long, vector<long long>>& buckets, UpdateStats& stats) {
+    vector<vector<long long>> localNext(pool.slots());
+    atomic<long long> lowered(0);
+
+    while (!buckets.empty()) {
+        long long d = buckets.begin()->first;
+        vector<long long> frontier = move(buckets.begin()->second);
+        buckets.erase(buckets.begin());
+        sort(frontier.begin(), frontier.end());
+        frontier.erase(unique(frontier.begin(), frontier.end()), frontier.end());
+        stats.touched += frontier.size();
+
+        pool.parallelFor(0, frontier.size(), LEVEL_GRAIN, [&](long lo, long hi) {
+            vector<long long>& next = localNext[pool.slot()];
+            long long local_lowered = 0;
+            for (long i = lo; i < hi; i++) {
+                long long x = frontier[i];
+                if (distance(x) != d) continue;  // lowered after it was queued
+                forEachNeighbor(x, [&](long long y) {
+                    long long current = distances[y].load(memory_order_relaxed);
+                    while (current > d + 1) {
+                        if (distances[y].compare_exchange_weak(current, d + 1, memory_order_relaxed)) {
+                            next.push_back(y);
+                            local_lowered++;
+                            break;
+                        }
+                    }
+                });
+            }
+            lowered.fetch_add(local_lowered, memory_order_relaxed);
+        });
+
+        for (vector<long long>& next : localNext) {
+            if (next.empty()) continue;
+            vector<long long>& bucket = buckets[d + 1];
+            bucket.insert(bucket.end(), next.begin(), next.end());
+            next.clear();
+        }
+    }
+    stats.changed += lowered.load();
+}
+
+DynamicGraph::UpdateStats DynamicGraph::applyBatch(ws::Scheduler& pool, const vector<Edge>& insertions,
+                                                   const vector<Edge>& deletions) {
+    UpdateStats stats;
+    vector<Edge> removed = directed(deletions);
+    vector<Edge> added = directed(insertions);
+    stats.deleted = deleteEntries(pool, removed) / 2;
+    insertEntries(pool, added);
+    stats.inserted = added.size() / 2;
+
+    // Reset the vertices that lost their path, then give each the best
+    // label its surviving neighbours offer; these and the inserted edges
+    // that shorten a path seed the decrease-only BFS. The labels are only
+    // written once all are computed, so each seed sees the same graph.
+    vector<long long> invalid = invalidate(pool, removed, stats);
+    vector<long long> best(invalid.size(), UNREACHED);
+    pool.parallelFor(0, invalid.size(), LEVEL_GRAIN, [&](long lo, long hi) {
+        for (long i = lo; i < hi; i++) {
+            forEachNeighbor(invalid[i], [&](long long x) {
+                long long dx = distance(x);
+                if (dx != UNREACHED && dx + 1 < best[i]) best[i] = dx + 1;
+            });
+        }
+    });
+
+    map<long long, vector<long long>> buckets;
+    for (size_t i = 0; i < invalid.size(); i++) {
+        if (best[i] == UNREACHED) continue;
+        distances[invalid[i]].store(best[i], memory_order_relaxed);
+        buckets[best[i]].push_back(invalid[i]);
+        stats.changed++;
+    }
+    for (const Edge& e : added) {
+        long long dv = distance(e.v);
+        if (dv != UNREACHED && dv + 1 < distance(e.w)) buckets[dv].push_back(e.v);
+    }
+    relax(pool, buckets, stats);
+    return stats;
+}
+
+void DynamicGraph::recompute(ws::Scheduler& pool) {
+    pool.parallelFor(0, vertices, LEVEL_GRAIN * 16, [&](long lo, long hi) {
+        for (long v = lo; v < hi; v++) distances[v].store(UNREACHED, memory_order_relaxed);
+    });
+    map<long long, vector<long long>> buckets;
+    for (long long root : roots) {
+        distances[root].store(0, memory_order_relaxed);
+        buckets[0].push_back(root);
+    }
+    UpdateStats ignored;
+    relax(pool, buckets, ignored);
+}
+
+bool DynamicGraph::verify() const {
+    vector<long long> expected(vertices, UNREACHED);
+    queue<long long> queue;
+    for (long long root : roots) {
+        if (expected[root] == 0) continue;
+        expected[root] = 0;
+        queue.push(root);
+    }
+    while (!queue.empty()) {
+        long long v = queue.front();
+        queue.pop();
+        forEachNeighbor(v, [&](long long w) {
+            if (expected[w] == UNREACHED) {
+                expected[w] = expected[v] + 1;
+                queue.push(w);
+            }
+        });
+    }
+    for (long long v = 0; v < vertices; v++) {
+        if (distance(v) != expected[v]) return false;
+    }
+    return true;
+}
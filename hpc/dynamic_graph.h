@@ -0,0 +1,102 @@
+// An undirected graph that changes in batches of edge insertions and
+// deletions while keeping the BFS distance of every vertex from a set of
+// roots (and so connectivity to them) up to date. A batch only repairs the
+// vertices whose distance it can change, and both the adjacency updates and
+// the repair run on the work-stealing pool.
+//
+// Adjacency lives in fixed-size blocks chained per vertex, so an insertion
+// fills a free slot or links a new block and a deletion swaps in the last
+// entry; nothing is ever rebuilt or moved.
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <map>
+#include <vector>
+#include "../common/work_stealing.h"
+
+class DynamicGraph {
+public:
+    struct Edge {
+        long long v;
+        long long w;
+    };
+
+    // What one batch did: how many edges changed, how many vertices lost
+    // their supporting path and had to be re-derived, and how many ended
+    // with a new distance. touched is every vertex the repair visited.
+    struct UpdateStats {
+        long long inserted = 0;
+        long long deleted = 0;
+        long long invalidated = 0;
+        long long changed = 0;
+        long long touched = 0;
+    };
+
+    static const long long UNREACHED = LLONG_MAX;
+
+private:
+    static const int BLOCK_EDGES = 6;
+
+    struct alignas(64) Block {
+        long long neighbors[BLOCK_EDGES];
+        int count;
+        int next;
+    };
+
+    // Vertices per task when a batch is applied or a level is relaxed.
+    static const int UPDATE_GRAIN = 64;
+    static const int LEVEL_GRAIN = 256;
+
+    long long vertices;
+    std::vector<long long> roots;
+
+    // head[v] is v's only partially filled block; the blocks behind it are
+    // full. degrees[v] counts the entries of all of them.
+    std::vector<Block> blocks;
+    std::vector<int> freeBlocks;
+    std::vector<int> head;
+    std::vector<long long> degrees;
+
+    std::vector<std::atomic<long long>> distances;
+    std::vector<std::atomic<bool>> marked;
+
+    template<typename F>
+    void forEachNeighbor(long long v, const F& f) const {
+        for (int b = head[v]; b >= 0; b = blocks[b].next) {
+            const Block& block = blocks[b];
+            for (int i = 0; i < block.count; i++) f(block.neighbors[i]);
+        }
+    }
+
+    static std::vector<Edge> directed(const std::vector<Edge>& batch);
+    bool removeEntry(long long v, long long w, std::vector<int>& freed);
+    long long deleteEntries(ws::Scheduler& pool, const std::vector<Edge>& entries);
+    void insertEntries(ws::Scheduler& pool, const std::vector<Edge>& entries);
+
+    std::vector<long long> invalidate(ws::Scheduler& pool, const std::vector<Edge>& deleted, UpdateStats& stats);
+    void relax(ws::Scheduler& pool, std::map<long long, std::vector<long long>>& buckets, UpdateStats& stats);
+
+public:
+    DynamicGraph(long long numVertices, const std::vector<long long>& rootVertices);
+
+    long long size() const { return vertices; }
+    long long degree(long long v) const { return degrees[v]; }
+    long long distance(long long v) const { return distances[v].load(std::memory_order_relaxed); }
+
+    // Vertices with a path to some root.
+    long long reached() const;
+
+    // Deletions are applied before insertions, so an edge in both lists
+    // ends up present. Deleting an edge that is not there is a no-op, and
+    // parallel edges are kept and deleted one at a time.
+    UpdateStats applyBatch(ws::Scheduler& pool, const std::vector<Edge>& insertions,
+                           const std::vector<Edge>& deletions);
+
+    // Distances from scratch: every vertex reset and a level-synchronous
+    // BFS from the roots, the cost a static graph pays after each batch.
+    void recompute(ws::Scheduler& pool);
+
+    // Checks every distance against a sequential BFS from the roots.
+    bool verify() const;
+};
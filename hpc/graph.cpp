@@ -0,0 +1,258 @@
+#include "graph.h"
+
+#include <queue>
+#include <random>
+#include <stack>
+#include <omp.h>
+
+using namespace std;
+
+Graph::Graph(long long v) : vertices(v) {
+    adjacencyList.resize(v);
+}
+
+Graph Graph::random(long long numVertices, long long numEdges, unsigned seed) {
+    Graph g(numVertices);
+    mt19937_64 gen(seed);
+    uniform_int_distribution<long long> vertex(0, numVertices - 1);
+    for (long long i = 0; i < numEdges; i++) {
+        long long v = vertex(gen);
+        long long w = vertex(gen);
+        g.addEdge(v, w);
+    }
+    return g;
+}
+
+void Graph::addEdge(long long v, long long w) {
+    adjacencyList[v].push_back(w);
+    adjacencyList[w].push_back(v);
+}
+
+double Graph::traversalOps() const {
+    double entries = 0;
+    for (const vector<long long>& list : adjacencyList) entries += list.size();
+    return entries;
+}
+
+double Graph::traversalBytes() const {
+    return traversalOps() * sizeof(long long) + vertices * (sizeof(vector<long long>) + 1.0);
+}
+
+// A vertex is claimed by whoever flips its flag first; the plain load
+// avoids the atomic write for the many already-visited neighbours.
+bool Graph::claim(vector<atomic<bool>>& visited, long long v) {
+    return !visited[v].load(memory_order_relaxed) && !visited[v].exchange(true, memory_order_relaxed);
+}
+
+long long Graph::sequentialBFS(long long startVertex) {
+    vector<bool> visited(vertices, false);
+    queue<long long> queue;
+    long long reached = 1;
+
+    visited[startVertex] = true;
+    queue.push(startVertex);
+
+    while (!queue.empty()) {
+        long long currentVertex = queue.front();
+        queue.pop();
+
+        for (long long adjacentVertex : adjacencyList[currentVertex]) {
+            if (!visited[adjacentVertex]) {
+                visited[adjacentVertex] = true;
+                queue.push(adjacentVertex);
+                reached++;
+            }
+        }
+    }
+    return reached;
+}
+
+long long Graph::parallelBFS(long long startVertex) {
+    vector<bool> visited(vertices, false);
+    vector<long long> frontier;
+    vector<long long> next_frontier;
+    long long reached = 0;
+
+    visited[startVertex] = true;
+    frontier.push_back(startVertex);
+
+    while (!frontier.empty()) {
+        reached += frontier.size();
+        next_frontier.clear();
+
+        #pragma omp parallel
+        {
+            vector<long long> local_frontier;
+
+            #pragma omp for nowait
+            for (size_t i = 0; i < frontier.size(); i++) {
+                long long currentVertex = frontier[i];
+
+                for (long long adjacentVertex : adjacencyList[currentVertex]) {
+                    #pragma omp critical
+                    {
+                        if (!visited[adjacentVertex]) {
+                            visited[adjacentVertex] = true;
+                            local_frontier.push_back(adjacentVertex);
+                        }
+                    }
+                }
+            }
+
+            #pragma omp critical
+            {
+                next_frontier.insert(next_frontier.end(), local_frontier.begin(), local_frontier.end());
+            }
+        }
+
+        frontier.swap(next_frontier);
+    }
+    return reached;
+}
+
+// Level-synchronous like parallelBFS, but each level is one parallel loop
+// on the persistent pool, vertices are claimed with an atomic flag instead
+// of a critical section, and each worker appends to its own buffer.
+long long Graph::workStealingBFS(ws::Scheduler& pool, long long startVertex) {
+    vector<atomic<bool>> visited(vertices);
+    vector<vector<long long>> localFrontiers(pool.slots());
+    vector<long long> frontier;
+    vector<long long> next_frontier;
+    long long reached = 0;
+
+    visited[startVertex] = true;
+    frontier.push_back(startVertex);
+
+    while (!frontier.empty()) {
+        reached += frontier.size();
+        pool.parallelFor(0, frontier.size(), BFS_GRAIN, [&](long lo, long hi) {
+            vector<long long>& local_frontier = localFrontiers[pool.slot()];
+            for (long i = lo; i < hi; i++) {
+                for (long long adjacentVertex : adjacencyList[frontier[i]]) {
+                    if (claim(visited, adjacentVertex)) {
+                        local_frontier.push_back(adjacentVertex);
+                    }
+                }
+            }
+        });
+
+        next_frontier.clear();
+        for (vector<long long>& local_frontier : localFrontiers) {
+            next_frontier.insert(next_frontier.end(), local_frontier.begin(), local_frontier.end());
+            local_frontier.clear();
+        }
+        frontier.swap(next_frontier);
+    }
+    return reached;
+}
+
+long long Graph::sequentialDFS(long long startVertex) {
+    vector<bool> visited(vertices, false);
+    stack<long long> stack;
+    long long reached = 0;
+
+    stack.push(startVertex);
+
+    while (!stack.empty()) {
+        long long currentVertex = stack.top();
+        stack.pop();
+
+        if (!visited[currentVertex]) {
+            visited[currentVertex] = true;
+            reached++;
+
+            for (long long adjacentVertex : adjacencyList[currentVertex]) {
+                if (!visited[adjacentVertex]) {
+                    stack.push(adjacentVertex);
+                }
+            }
+        }
+    }
+    return reached;
+}
+
+long long Graph::parallelDFS(long long startVertex) {
+    vector<bool> visited(vertices, false);
+    stack<long long> stack;
+    long long reached = 0;
+
+    visited[startVertex] = true;
+    stack.push(startVertex);
+
+    while (!stack.empty()) {
+        vector<long long> current_level;
+
+        while (!stack.empty()) {
+            current_level.push_back(stack.top());
+            stack.pop();
+        }
+        reached += current_level.size();
+
+        #pragma omp parallel
+        {
+            vector<long long> local_stack;
+
+            #pragma omp for nowait
+            for (size_t i = 0; i < current_level.size(); i++) {
+                long long currentVertex = current_level[i];
+
+                for (long long adjacentVertex : adjacencyList[currentVertex]) {
+                    #pragma omp critical
+                    {
+                        if (!visited[adjacentVertex]) {
+                            visited[adjacentVertex] = true;
+                            local_stack.push_back(adjacentVertex);
+                        }
+                    }
+                }
+            }
+
+            #pragma omp critical
+            {
+                for (long long vertex : local_stack) {
+                    stack.push(vertex);
+                }
+            }
+        }
+    }
+    return reached;
+}
+
+long long Graph::exploreFrom(ws::TaskGroup& group, vector<atomic<bool>>& visited, atomic<long long>& reached,
+                             vector<long long> stack) {
+    long long explored = 0;
+    while (!stack.empty()) {
+        if (stack.size() > 2 * DFS_GRAIN) {
+            vector<long long> half(stack.begin(), stack.begin() + stack.size() / 2);
+            stack.erase(stack.begin(), stack.begin() + stack.size() / 2);
+            group.spawn([this, &group, &visited, &reached, half = move(half)]() mutable {
+                reached.fetch_add(exploreFrom(group, visited, reached, move(half)), memory_order_relaxed);
+            });
+        }
+
+        long long currentVertex = stack.back();
+        stack.pop_back();
+        explored++;
+
+        for (long long adjacentVertex : adjacencyList[currentVertex]) {
+            if (claim(visited, adjacentVertex)) {
+                stack.push_back(adjacentVertex);
+            }
+        }
+    }
+    return explored;
+}
+
+// Depth-first without levels: one task walks its own stack, and when the
+// stack grows past twice the grain it spawns the older half, which idle
+// workers steal. The traversal ends when the group drains.
+long long Graph::workStealingDFS(ws::Scheduler& pool, long long startVertex) {
+    vector<atomic<bool>> visited(vertices);
+    atomic<long long> reached(0);
+    visited[startVertex] = true;
+
+    ws::TaskGroup group(pool);
+    reached.fetch_add(exploreFrom(group, visited, reached, vector<long long>(1, startVertex)));
+    group.sync();
+    return reached.load();
+}
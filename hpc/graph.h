@@ -0,0 +1,47 @@
+// Undirected graph and the traversals of practical one: sequential,
+// OpenMP and work-stealing BFS and DFS. Every traversal returns the number
+// of vertices it reached, so callers can check one against another.
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "../common/work_stealing.h"
+
+class Graph {
+private:
+    long long vertices;
+    std::vector<std::vector<long long>> adjacencyList;
+
+    // Frontier slice per work-stealing task, and the stack depth at which a
+    // DFS task hands half of its stack to an idle worker.
+    static const int BFS_GRAIN = 256;
+    static const int DFS_GRAIN = 1024;
+
+    static bool claim(std::vector<std::atomic<bool>>& visited, long long v);
+    long long exploreFrom(ws::TaskGroup& group, std::vector<std::atomic<bool>>& visited,
+                          std::atomic<long long>& reached, std::vector<long long> stack);
+
+public:
+    Graph(long long v);
+
+    // numEdges edges between uniformly random endpoints, as in practical
+    // one, but from a seeded generator so that runs are repeatable.
+    static Graph random(long long numVertices, long long numEdges, unsigned seed);
+
+    long long size() const { return vertices; }
+
+    void addEdge(long long v, long long w);
+
+    // Declared work for a full traversal: every adjacency entry is examined
+    // once, and the lists plus a visited flag per vertex are read.
+    double traversalOps() const;
+    double traversalBytes() const;
+
+    long long sequentialBFS(long long startVertex);
+    long long parallelBFS(long long startVertex);
+    long long workStealingBFS(ws::Scheduler& pool, long long startVertex);
+
+    long long sequentialDFS(long long startVertex);
+    long long parallelDFS(long long startVertex);
+    long long workStealingDFS(ws::Scheduler& pool, long long startVertex);
+};
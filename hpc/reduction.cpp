@@ -0,0 +1,143 @@
+#include "reduction.h"
+
+#include <limits>
+#include <random>
+#include <omp.h>
+
+using namespace std;
+
+vector<int> ParallelReduction::generateRandomData(int size, int min, int max) {
+    vector<int> result(size);
+    random_device rd;
+    mt19937 gen(rd());
+    uniform_int_distribution<> distrib(min, max);
+    
+    for (int i = 0; i < size; i++) {
+        result[i] = distrib(gen);
+    }
+    
+    return result;
+}
+
+ParallelReduction::ParallelReduction(int dataSize, int minVal, int maxVal) : size(dataSize) {
+    data = generateRandomData(size, minVal, maxVal);
+}
+
+int ParallelReduction::sequentialMin() {
+    int minVal = numeric_limits<int>::max();
+    for (int i = 0; i < size; i++) {
+        if (data[i] < minVal) {
+            minVal = data[i];
+        }
+    }
+    return minVal;
+}
+
+int ParallelReduction::parallelMin() {
+    int minVal = numeric_limits<int>::max();
+    
+    #pragma omp parallel reduction(min:minVal)
+    {
+        #pragma omp for
+        for (int i = 0; i < size; i++) {
+            if (data[i] < minVal) {
+                minVal = data[i];
+            }
+        }
+    }
+    
+    return minVal;
+}
+
+int ParallelReduction::sequentialMax() {
+    int maxVal = numeric_limits<int>::min();
+    for (int i = 0; i < size; i++) {
+        if (data[i] > maxVal) {
+            maxVal = data[i];
+        }
+    }
+    return maxVal;
+}
+
+int ParallelReduction::parallelMax() {
+    int maxVal = numeric_limits<int>::min();
+    
+    #pragma omp parallel reduction(max:maxVal)
+    {
+        #pragma omp for
+        for (int i = 0; i < size; i++) {
+            if (data[i] > maxVal) {
+                maxVal = data[i];
+            }
+        }
+    }
+    
+    return maxVal;
+}
+
+long long ParallelReduction::sequentialSum() {
+    long long sum = 0;
+    for (int i = 0; i < size; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+long long ParallelReduction::parallelSum() {
+    long long sum = 0;
+    
+    #pragma omp parallel reduction(+:sum)
+    {
+        #pragma omp for
+        for (int i = 0; i < size; i++) {
+            sum += data[i];
+        }
+    }
+    
+    return sum;
+}
+
+double ParallelReduction::sequentialAverage() {
+    long long sum = sequentialSum();
+    return static_cast<double>(sum) / size;
+}
+
+double ParallelReduction::parallelAverage() {
+    long long sum = parallelSum();
+    return static_cast<double>(sum) / size;
+}
+
+void ParallelReduction::runBenchmark() {
+    int numThreads;
+    #pragma omp parallel
+    {
+        #pragma omp master
+        numThreads = omp_get_num_threads();
+    }
+    
+    cout << "Array size: " << size << ", Number of threads: " << numThreads << endl;
+    cout << "------------------------------------------------------------" << endl;
+    
+    // Measure sequential operations
+    double seqMinTime = measureExecutionTime([this]() { return this->sequentialMin(); }, "Sequential Min");
+    double seqMaxTime = measureExecutionTime([this]() { return this->sequentialMax(); }, "Sequential Max");
+    double seqSumTime = measureExecutionTime([this]() { return this->sequentialSum(); }, "Sequential Sum");
+    double seqAvgTime = measureExecutionTime([this]() { return this->sequentialAverage(); }, "Sequential Average");
+    
+    cout << "------------------------------------------------------------" << endl;
+    
+    // Measure parallel operations
+    double parMinTime = measureExecutionTime([this]() { return this->parallelMin(); }, "Parallel Min");
+    double parMaxTime = measureExecutionTime([this]() { return this->parallelMax(); }, "Parallel Max");
+    double parSumTime = measureExecutionTime([this]() { return this->parallelSum(); }, "Parallel Sum");
+    double parAvgTime = measureExecutionTime([this]() { return this->parallelAverage(); }, "Parallel Average");
+    
+    cout << "------------------------------------------------------------" << endl;
+    
+    // Calculate speedups
+    cout << "Speedups:" << endl;
+    cout << "Min: " << fixed << setprecision(2) << (seqMinTime / parMinTime) << "x" << endl;
+    cout << "Max: " << fixed << setprecision(2) << (seqMaxTime / parMaxTime) << "x" << endl;
+    cout << "Sum: " << fixed << setprecision(2) << (seqSumTime / parSumTime) << "x" << endl;
+    cout << "Average: " << fixed << setprecision(2) << (seqAvgTime / parAvgTime) << "x" << endl;
+}
@@ -0,0 +1,58 @@
+// The reductions of practical three: sequential and OpenMP min, max, sum
+// and average over a random integer array, plus the timing report that
+// three.cpp prints.
+#pragma once
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../common/perf_regions.h"
+
+class ParallelReduction {
+private:
+    std::vector<int> data;
+    int size;
+    
+    std::vector<int> generateRandomData(int size, int min, int max);
+    
+    // Every reduction reads each element once and does one operation on it.
+    template<typename Operation>
+    double measureExecutionTime(Operation op, const std::string& name) {
+        std::chrono::high_resolution_clock::time_point start, end;
+        decltype(op()) result;
+        {
+            perf::Region region(name, size, static_cast<double>(size) * sizeof(int));
+            start = std::chrono::high_resolution_clock::now();
+            result = op();
+            end = std::chrono::high_resolution_clock::now();
+        }
+        
+        std::chrono::duration<double, std::milli> duration = end - start;
+        std::cout << name << " result: " << result << ", Time: " << std::fixed << std::setprecision(3) << duration.count() << " ms" << std::endl;
+        
+        return duration.count();
+    }
+    
+public:
+    ParallelReduction(int dataSize, int minVal, int maxVal);
+    
+    int sequentialMin();
+    
+    int parallelMin();
+    
+    int sequentialMax();
+    
+    int parallelMax();
+    
+    long long sequentialSum();
+    
+    long long parallelSum();
+    
+    double sequentialAverage();
+    
+    double parallelAverage();
+    
+    void runBenchmark();
+};
@@ -0,0 +1,1516 @@
+// The MPI sample sort of the mini project, header-only so that any MPI
+// program can sort, select from or verify distributed vectors of int,
+// Record or std::string with it: parallel_sample_sort, distributed_select
+// (k-th elements and quantiles), distributed_top_k, verify_distributed_sorted,
+// the binary file I/O and the random input generators. Must stay C++11.
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <string>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../common/perf_regions.h"
+
+// The single-process baseline the speedup is measured against, and the
+// check of its result. In a namespace so that they never compete with
+// std::partition and std::is_sorted.
+namespace sequential {
+
+template<typename T>
+long long partition(std::vector<T>& arr, long long low, long long high) {
+    T pivot = arr[high];
+    long long i = (low - 1);
+    for (long long j = low; j <= high - 1; j++) {
+        if (arr[j] < pivot) {
+            i++;
+            std::swap(arr[i], arr[j]);
+        }
+    }
+    std::swap(arr[i + 1], arr[high]);
+    return (i + 1);
+}
+
+template<typename T>
+void quicksort(std::vector<T>& arr, long long low, long long high) {
+    if (low < high) {
+        long long pi = partition(arr, low, high);
+        quicksort(arr, low, pi - 1);
+        quicksort(arr, pi + 1, high);
+    }
+}
+
+template<typename T>
+bool is_sorted(const std::vector<T>& arr) {
+    for (size_t i = 0; i + 1 < arr.size(); ++i) {
+        if (arr[i + 1] < arr[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace sequential
+
+// Block distribution of N elements over `size` ranks: the first N % size
+// ranks get one extra element.
+inline void block_range(long long N, int size, int rank, long long& offset, long long& count) {
+    long long base = N / size;
+    long long remainder = N % size;
+    count = base + (rank < remainder ? 1 : 0);
+    offset = rank * base + (rank < remainder ? rank : remainder);
+}
+
+// Tuning knobs for the sample sort, settable from the command line.
+struct SortOptions {
+    int oversample = 4;          // regular samples per rank = oversample * p
+    int refine_rounds = 0;       // histogram refinement rounds, 0 = off
+    double tolerance = 0.02;     // accepted bucket error, as a fraction of N / p
+    bool report_buckets = false; // print every rank's bucket size
+    long long chunk_elems = 1 << 22; // largest single message in the exchange (bytes for strings)
+    int pipeline_depth = 2;      // exchange rounds in flight at once
+};
+
+// Byte-buffer packing for anything that crosses the network as raw bytes
+// (splitter keys, boundary elements, strings).
+template<typename V>
+void pack_pod(const V& value, std::vector<char>& buf) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buf.insert(buf.end(), bytes, bytes + sizeof(V));
+}
+
+template<typename V>
+V unpack_pod(const char*& p) {
+    V value;
+    std::memcpy(&value, p, sizeof(V));
+    p += sizeof(V);
+    return value;
+}
+
+// Key-value record: sorted by key, the payload travels with it. The payload
+// is derived from the key, so verification can tell whether it survived the
+// exchange intact.
+const int RECORD_PAYLOAD = 56;
+
+struct Record {
+    uint64_t key;
+    char payload[RECORD_PAYLOAD];
+};
+
+inline bool operator<(const Record& a, const Record& b) {
+    return a.key < b.key;
+}
+
+inline char record_payload_byte(uint64_t key, int j) {
+    return static_cast<char>((key >> (8 * (j % 8))) ^ (j * 37));
+}
+
+inline Record make_record(uint64_t key) {
+    Record r;
+    r.key = key;
+    for (int j = 0; j < RECORD_PAYLOAD; ++j) r.payload[j] = record_payload_byte(key, j);
+    return r;
+}
+
+// SplitMix64 finalizer: spreads element hashes over all 64 bits before they
+// are summed into a checksum.
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Everything the sort needs to know about an element type. Fixed-size types
+// move as an MPI datatype; variable-size types (strings) are packed into
+// length-prefixed bytes. bytes() is the element's share of the reported
+// bandwidth, valid() checks an element after it has been moved, hash()
+// feeds the input/output checksum, format() prints it.
+template<typename T>
+struct SortTraits;
+
+template<>
+struct SortTraits<int> {
+    static const bool fixed_size = true;
+    static const char* name() { return "int"; }
+    static std::string format(const int& x) { return std::to_string(x); }
+    static MPI_Datatype datatype() { return MPI_INT; }
+    static long long bytes(const int&) { return sizeof(int); }
+    static bool valid(const int&) { return true; }
+    static uint64_t hash(const int& x) { return static_cast<uint32_t>(x); }
+    static void pack(const int& x, std::vector<char>& buf) { pack_pod(x, buf); }
+    static int unpack(const char*& p) { return unpack_pod<int>(p); }
+};
+
+template<>
+struct SortTraits<Record> {
+    static const bool fixed_size = true;
+    static const char* name() { return "record"; }
+    static std::string format(const Record& r) { return "key " + std::to_string(r.key); }
+
+    // {uint64 key, 56 chars}, resized to sizeof(Record) so arrays of
+    // records can be sent with a count instead of a byte length.
+    static MPI_Datatype datatype() {
+        static MPI_Datatype type = MPI_DATATYPE_NULL;
+        if (type == MPI_DATATYPE_NULL) {
+            int lengths[2] = {1, RECORD_PAYLOAD};
+            MPI_Aint displs[2] = {offsetof(Record, key), offsetof(Record, payload)};
+            MPI_Datatype types[2] = {MPI_UINT64_T, MPI_CHAR};
+            MPI_Datatype packed;
+            MPI_Type_create_struct(2, lengths, displs, types, &packed);
+            MPI_Type_create_resized(packed, 0, sizeof(Record), &type);
+            MPI_Type_commit(&type);
+            MPI_Type_free(&packed);
+        }
+        return type;
+    }
+    static long long bytes(const Record&) { return sizeof(Record); }
+    static bool valid(const Record& r) {
+        for (int j = 0; j < RECORD_PAYLOAD; ++j) {
+            if (r.payload[j] != record_payload_byte(r.key, j)) return false;
+        }
+        return true;
+    }
+    // The payload is covered by valid().
+    static uint64_t hash(const Record& r) { return r.key; }
+    static void pack(const Record& r, std::vector<char>& buf) { pack_pod(r, buf); }
+    static Record unpack(const char*& p) { return unpack_pod<Record>(p); }
+};
+
+template<>
+struct SortTraits<std::string> {
+    static const bool fixed_size = false;
+    static const char* name() { return "string"; }
+    static std::string format(const std::string& s) { return "\"" + s + "\""; }
+    // Never used for transfers (run_distributed rejects file I/O first);
+    // it only lets the fixed-size code paths compile for strings.
+    static MPI_Datatype datatype() { return MPI_DATATYPE_NULL; }
+    static long long bytes(const std::string& s) { return s.size(); }
+    static bool valid(const std::string&) { return true; }
+    static uint64_t hash(const std::string& s) {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i < s.size(); ++i) h = (h ^ static_cast<unsigned char>(s[i])) * 1099511628211ULL;
+        return h;
+    }
+    static void pack(const std::string& s, std::vector<char>& buf) {
+        pack_pod(static_cast<uint32_t>(s.size()), buf);
+        buf.insert(buf.end(), s.begin(), s.end());
+    }
+    static std::string unpack(const char*& p) {
+        uint32_t length = unpack_pod<uint32_t>(p);
+        std::string s(p, length);
+        p += length;
+        return s;
+    }
+};
+
+// MPI counts are int. Larger transfers are described as whole blocks of a
+// contiguous derived type plus a remainder of single elements, which covers
+// up to 2^31 blocks of LARGE_BLOCK elements per call.
+const long long LARGE_BLOCK = 1 << 20;
+
+template<typename T>
+MPI_Datatype large_block_type() {
+    static MPI_Datatype type = MPI_DATATYPE_NULL;
+    if (type == MPI_DATATYPE_NULL) {
+        MPI_Type_contiguous(static_cast<int>(LARGE_BLOCK), SortTraits<T>::datatype(), &type);
+        MPI_Type_commit(&type);
+    }
+    return type;
+}
+
+inline void send_large(const int* buf, long long count, int dest, int tag, MPI_Comm comm) {
+    int blocks = static_cast<int>(count / LARGE_BLOCK);
+    int rest = static_cast<int>(count % LARGE_BLOCK);
+    MPI_Send(buf, blocks, large_block_type<int>(), dest, tag, comm);
+    MPI_Send(buf + blocks * LARGE_BLOCK, rest, MPI_INT, dest, tag, comm);
+}
+
+inline void recv_large(int* buf, long long count, int src, int tag, MPI_Comm comm) {
+    int blocks = static_cast<int>(count / LARGE_BLOCK);
+    int rest = static_cast<int>(count % LARGE_BLOCK);
+    MPI_Recv(buf, blocks, large_block_type<int>(), src, tag, comm, MPI_STATUS_IGNORE);
+    MPI_Recv(buf + blocks * LARGE_BLOCK, rest, MPI_INT, src, tag, comm, MPI_STATUS_IGNORE);
+}
+
+// Collects every rank's bytes on root, concatenated in rank order.
+inline std::vector<char> gather_bytes(const std::vector<char>& local, int root, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int local_count = local.size();
+    std::vector<int> counts(size), displs(size);
+    MPI_Gather(&local_count, 1, MPI_INT, counts.data(), 1, MPI_INT, root, comm);
+    std::vector<char> all;
+    if (rank == root) {
+        int total = 0;
+        for (int r = 0; r < size; ++r) {
+            displs[r] = total;
+            total += counts[r];
+        }
+        all.resize(total);
+    }
+    MPI_Gatherv(local.data(), local_count, MPI_BYTE, all.data(), counts.data(), displs.data(), MPI_BYTE, root, comm);
+    return all;
+}
+
+// As gather_bytes, but every rank gets the concatenation.
+inline std::vector<char> allgather_bytes(const std::vector<char>& local, MPI_Comm comm) {
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    int local_count = local.size();
+    std::vector<int> counts(size), displs(size);
+    MPI_Allgather(&local_count, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+    int total = 0;
+    for (int r = 0; r < size; ++r) {
+        displs[r] = total;
+        total += counts[r];
+    }
+    std::vector<char> all(total);
+    MPI_Allgatherv(local.data(), local_count, MPI_BYTE, all.data(), counts.data(), displs.data(), MPI_BYTE, comm);
+    return all;
+}
+
+// Replaces buf on every rank with root's buf.
+inline void bcast_bytes(std::vector<char>& buf, int root, MPI_Comm comm) {
+    int count = buf.size();
+    MPI_Bcast(&count, 1, MPI_INT, root, comm);
+    buf.resize(count);
+    MPI_Bcast(buf.data(), count, MPI_BYTE, root, comm);
+}
+
+// Splitter key: (value, global index). Ordering by the pair makes every
+// element distinct, so a long run of equal values can be cut between ranks
+// instead of landing on one of them. `bound` gives every element type a key
+// below (-1) and above (+1) all elements.
+template<typename T>
+struct SplitKey {
+    T value;
+    long long index;
+    int bound;
+};
+
+template<typename T>
+bool operator<(const SplitKey<T>& a, const SplitKey<T>& b) {
+    if (a.bound != b.bound) return a.bound < b.bound;
+    if (a.bound != 0) return false;
+    return a.value < b.value || (!(b.value < a.value) && a.index < b.index);
+}
+
+template<typename T>
+SplitKey<T> make_split_key(const T& value, long long index) {
+    SplitKey<T> key = SplitKey<T>();
+    key.value = value;
+    key.index = index;
+    key.bound = 0;
+    return key;
+}
+
+template<typename T>
+SplitKey<T> bound_split_key(int bound) {
+    SplitKey<T> key = SplitKey<T>();
+    key.index = bound < 0 ? -1 : std::numeric_limits<long long>::max();
+    key.bound = bound;
+    return key;
+}
+
+template<typename T>
+void pack_key(const SplitKey<T>& key, std::vector<char>& buf) {
+    pack_pod(static_cast<signed char>(key.bound), buf);
+    pack_pod(key.index, buf);
+    if (key.bound == 0) SortTraits<T>::pack(key.value, buf);
+}
+
+template<typename T>
+SplitKey<T> unpack_key(const char*& p) {
+    SplitKey<T> key = SplitKey<T>();
+    key.bound = unpack_pod<signed char>(p);
+    key.index = unpack_pod<long long>(p);
+    if (key.bound == 0) key.value = SortTraits<T>::unpack(p);
+    return key;
+}
+
+template<typename T>
+std::vector<SplitKey<T>> unpack_keys(const std::vector<char>& buf) {
+    std::vector<SplitKey<T>> keys;
+    const char* p = buf.data();
+    const char* end = p + buf.size();
+    while (p < end) keys.push_back(unpack_key<T>(p));
+    return keys;
+}
+
+// Branchless lower bound: index of the first element for which
+// less_than_key is false. The loop runs a fixed ~log2(n) times and the
+// comparison selects the next base with a conditional move, so searches
+// with unpredictable outcomes cost no branch mispredictions.
+template<typename T, typename Less>
+long long branchless_lower_bound(const T* data, long long n, Less less_than_key) {
+    if (n <= 0) return 0;
+    const T* base = data;
+    while (n > 1) {
+        long long half = n / 2;
+        base = less_than_key(base[half]) ? base + half : base;
+        n -= half;
+    }
+    return (base - data) + (less_than_key(*base) ? 1 : 0);
+}
+
+// A sorted input range [first, last) for the k-way merge.
+template<typename T>
+struct Run {
+    const T* first;
+    const T* last;
+};
+
+// Tournament tree of losers over k sorted runs. Each output element costs
+// one leaf-to-root replay of ceil(log2 k) comparisons, so merging p runs
+// of n elements in total is O(n log p) instead of re-sorting in O(n log n).
+// Ties go to the lower run index, keeping the merge stable.
+template<typename T>
+class LoserTree {
+private:
+    int k;
+    std::vector<Run<T>> runs;
+    std::vector<int> losers; // losers[0] is the overall winner
+
+    bool beats(int a, int b) const {
+        if (runs[a].first == runs[a].last) return false;
+        if (runs[b].first == runs[b].last) return true;
+        if (*runs[b].first < *runs[a].first) return false;
+        if (*runs[a].first < *runs[b].first) return true;
+        return a < b;
+    }
+
+public:
+    explicit LoserTree(const std::vector<Run<T>>& inputs) : k(inputs.size()), runs(inputs), losers(inputs.size()) {
+        if (k == 0) return;
+        // Leaves are nodes k..2k-1; winners bubble up while losers stay put.
+        std::vector<int> winners(2 * k);
+        for (int i = 0; i < k; ++i) winners[k + i] = i;
+        for (int node = k - 1; node >= 1; --node) {
+            int left = winners[2 * node];
+            int right = winners[2 * node + 1];
+            bool left_wins = beats(left, right);
+            winners[node] = left_wins ? left : right;
+            losers[node] = left_wins ? right : left;
+        }
+        losers[0] = k > 1 ? winners[1] : 0;
+    }
+
+    // Writes the next `count` merged elements to out.
+    void merge_into(T* out, long long count) {
+        for (long long produced = 0; produced < count; ++produced) {
+            int winner = losers[0];
+            *out++ = *runs[winner].first++;
+            for (int node = (winner + k) / 2; node >= 1; node /= 2) {
+                if (beats(losers[node], winner)) std::swap(losers[node], winner);
+            }
+            losers[0] = winner;
+        }
+    }
+};
+
+// LCP-aware loser tree for strings. Every head carries h, its longest
+// common prefix with the string it was last compared against: for a loser
+// stored at a node that is the winner of that game, and all losers on the
+// path of the last output share that reference. Two heads with different h
+// are then ordered without reading a character (the larger h is smaller),
+// and with equal h the comparison starts at h, so shared prefixes such as
+// URLs or paths are not re-scanned at every tree level.
+class LcpLoserTree {
+private:
+    int k;
+    std::vector<Run<std::string>> runs;
+    std::vector<int> losers; // losers[0] is the overall winner
+    std::vector<size_t> h;   // per run: lcp of its head with its reference
+
+    static size_t common_prefix(const std::string& a, const std::string& b, size_t from) {
+        size_t n = std::min(a.size(), b.size());
+        while (from < n && a[from] == b[from]) ++from;
+        return from;
+    }
+
+    // Plays a against b, both h values relative to the same string. The
+    // loser's h is updated to its lcp with the winner.
+    bool beats(int a, int b) {
+        if (runs[a].first == runs[a].last) return false;
+        if (runs[b].first == runs[b].last) return true;
+        if (h[a] != h[b]) return h[a] > h[b];
+        const std::string& x = *runs[a].first;
+        const std::string& y = *runs[b].first;
+        size_t m = common_prefix(x, y, h[a]);
+        bool a_wins;
+        if (m < x.size() && m < y.size()) {
+            a_wins = static_cast<unsigned char>(x[m]) < static_cast<unsigned char>(y[m]);
+        } else if (x.size() != y.size()) {
+            a_wins = x.size() < y.size();
+        } else {
+            a_wins = a < b;
+        }
+        h[a_wins ? b : a] = m;
+        return a_wins;
+    }
+
+public:
+    explicit LcpLoserTree(const std::vector<Run<std::string>>& inputs)
+        : k(inputs.size()), runs(inputs), losers(inputs.size()), h(inputs.size(), 0) {
+        if (k == 0) return;
+        // All heads start relative to the empty string, so h = 0.
+        std::vector<int> winners(2 * k);
+        for (int i = 0; i < k; ++i) winners[k + i] = i;
+        for (int node = k - 1; node >= 1; --node) {
+            int left = winners[2 * node];
+            int right = winners[2 * node + 1];
+            bool left_wins = beats(left, right);
+            winners[node] = left_wins ? left : right;
+            losers[node] = left_wins ? right : left;
+        }
+        losers[0] = k > 1 ? winners[1] : 0;
+    }
+
+    void merge_into(std::string* out, long long count) {
+        for (long long produced = 0; produced < count; ++produced) {
+            int winner = losers[0];
+            const std::string& emitted = *runs[winner].first++;
+            *out++ = emitted;
+            // The next head's reference is the string just emitted.
+            if (runs[winner].first != runs[winner].last) h[winner] = common_prefix(emitted, *runs[winner].first, 0);
+            for (int node = (winner + k) / 2; node >= 1; node /= 2) {
+                if (beats(losers[node], winner)) std::swap(losers[node], winner);
+            }
+            losers[0] = winner;
+        }
+    }
+};
+
+// Sequential k-way merge of one output slice; strings use the LCP tree.
+template<typename T>
+void merge_runs(const std::vector<Run<T>>& runs, T* out, long long count) {
+    LoserTree<T> tree(runs);
+    tree.merge_into(out, count);
+}
+
+inline void merge_runs(const std::vector<Run<std::string>>& runs, std::string* out, long long count) {
+    LcpLoserTree tree(runs);
+    tree.merge_into(out, count);
+}
+
+// Multi-sequence selection: cut positions in each run such that the cuts
+// hold exactly the `target` smallest elements (ties broken by run index).
+// Each round pivots on the weighted median of the runs' midpoints, which
+// discards at least a quarter of the remaining candidates, so only
+// O(log n) rounds of per-run binary searches are needed.
+template<typename T>
+std::vector<long long> multiway_split(const std::vector<Run<T>>& runs, long long target) {
+    int k = runs.size();
+    std::vector<long long> lo(k, 0), hi(k);
+    for (int r = 0; r < k; ++r) hi[r] = runs[r].last - runs[r].first;
+
+    while (true) {
+        long long taken = 0;
+        std::vector<std::pair<T, long long>> mids;
+        for (int r = 0; r < k; ++r) {
+            taken += lo[r];
+            if (lo[r] < hi[r]) mids.push_back(std::make_pair(runs[r].first[(lo[r] + hi[r]) / 2], hi[r] - lo[r]));
+        }
+        if (mids.empty() || taken == target) return lo;
+
+        std::sort(mids.begin(), mids.end(),
+                  [](const std::pair<T, long long>& a, const std::pair<T, long long>& b) { return a.first < b.first; });
+        long long total_weight = 0, weight = 0;
+        for (size_t m = 0; m < mids.size(); ++m) total_weight += mids[m].second;
+        T pivot = mids.back().first;
+        for (size_t m = 0; m < mids.size(); ++m) {
+            weight += mids[m].second;
+            if (2 * weight >= total_weight) {
+                pivot = mids[m].first;
+                break;
+            }
+        }
+
+        std::vector<long long> below(k), through(k);
+        long long count_below = 0, count_through = 0;
+        for (int r = 0; r < k; ++r) {
+            const T* base = runs[r].first + lo[r];
+            long long n = hi[r] - lo[r];
+            below[r] = lo[r] + branchless_lower_bound(base, n, [&](const T& x) { return x < pivot; });
+            through[r] = lo[r] + branchless_lower_bound(base, n, [&](const T& x) { return !(pivot < x); });
+            count_below += below[r];
+            count_through += through[r];
+        }
+
+        if (target <= count_below) {
+            hi = below;
+        } else if (target >= count_through) {
+            lo = through;
+        } else {
+            // The cut falls inside the run of elements equal to the pivot:
+            // take them in run order.
+            long long remaining = target - count_below;
+            for (int r = 0; r < k; ++r) {
+                long long take = std::min(remaining, through[r] - below[r]);
+                lo[r] = below[r] + take;
+                remaining -= take;
+            }
+            return lo;
+        }
+    }
+}
+
+// Merges sorted runs into out (which must hold all of them). The output is
+// cut into one equal slice per thread with multiway_split, and every thread
+// merges its slice with its own loser tree.
+template<typename T>
+void parallel_multiway_merge(const std::vector<Run<T>>& runs, T* out, long long total) {
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = std::max(1, static_cast<int>(std::min<long long>(omp_get_max_threads(), total / 65536)));
+#endif
+    #pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+    for (int t = 0; t < num_threads; ++t) {
+        long long begin = total * t / num_threads;
+        long long end = total * (t + 1) / num_threads;
+        std::vector<long long> cut_begin = multiway_split(runs, begin);
+        std::vector<long long> cut_end = multiway_split(runs, end);
+        std::vector<Run<T>> slice(runs.size());
+        for (size_t r = 0; r < runs.size(); ++r) {
+            slice[r].first = runs[r].first + cut_begin[r];
+            slice[r].last = runs[r].first + cut_end[r];
+        }
+        merge_runs(slice, out + begin, end - begin);
+    }
+}
+
+// Number of local elements ordered before `key`. local_data is sorted and
+// its i-th element has global index rank_offset + i.
+template<typename T>
+long long local_rank_of(const std::vector<T>& local_data, long long rank_offset, const SplitKey<T>& key) {
+    if (key.bound < 0) return 0;
+    if (key.bound > 0) return local_data.size();
+    const T& value = key.value;
+    long long first = branchless_lower_bound(local_data.data(), local_data.size(),
+                                             [&value](const T& x) { return x < value; });
+    long long last = first + branchless_lower_bound(local_data.data() + first, local_data.size() - first,
+                                                    [&value](const T& x) { return !(value < x); });
+    long long pos = key.index - rank_offset;
+    return std::min(std::max(pos, first), last);
+}
+
+// Global rank of each key: local ranks summed over all processes.
+template<typename T>
+std::vector<long long> global_ranks_of(const std::vector<SplitKey<T>>& keys, const std::vector<T>& local_data,
+                                       long long rank_offset, MPI_Comm comm) {
+    std::vector<long long> local_ranks(keys.size());
+    for (size_t k = 0; k < keys.size(); ++k) {
+        local_ranks[k] = local_rank_of(local_data, rank_offset, keys[k]);
+    }
+    std::vector<long long> ranks(keys.size());
+    MPI_Allreduce(local_ranks.data(), ranks.data(), static_cast<int>(keys.size()), MPI_LONG_LONG, MPI_SUM, comm);
+    return ranks;
+}
+
+// Histogram refinement: every round measures the global rank of each
+// candidate splitter with one MPI_Allreduce, narrows a [lo, hi] bracket
+// around the target rank (i+1) * N / p, and samples new candidates only
+// from inside the still-open brackets. Only counts and a few samples cross
+// the network.
+template<typename T>
+void refine_splitters(std::vector<SplitKey<T>>& splitters, const std::vector<T>& local_data, long long rank_offset,
+                      long long N, const SortOptions& opts, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int num_splitters = size - 1;
+    long long tolerance = std::max(1LL, static_cast<long long>(opts.tolerance * N / size));
+    int per_bracket = std::max(2, opts.oversample);
+
+    std::vector<SplitKey<T>> lo(num_splitters, bound_split_key<T>(-1)), hi(num_splitters, bound_split_key<T>(1));
+    std::vector<long long> lo_rank(num_splitters, 0), hi_rank(num_splitters, N);
+    std::vector<long long> best_error(num_splitters, std::numeric_limits<long long>::max());
+
+    std::vector<SplitKey<T>> candidates = splitters;
+    std::vector<int> owner(num_splitters);
+    for (int i = 0; i < num_splitters; ++i) owner[i] = i;
+
+    for (int round = 0; ; ++round) {
+        std::vector<long long> ranks = global_ranks_of(candidates, local_data, rank_offset, comm);
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            int i = owner[c];
+            long long target = static_cast<long long>(i + 1) * N / size;
+            long long error = std::llabs(ranks[c] - target);
+            if (error < best_error[i]) {
+                best_error[i] = error;
+                splitters[i] = candidates[c];
+            }
+            if (ranks[c] <= target && lo[i] < candidates[c]) {
+                lo[i] = candidates[c];
+                lo_rank[i] = ranks[c];
+            }
+            if (ranks[c] >= target && candidates[c] < hi[i]) {
+                hi[i] = candidates[c];
+                hi_rank[i] = ranks[c];
+            }
+        }
+
+        std::vector<int> open;
+        for (int i = 0; i < num_splitters; ++i) {
+            if (best_error[i] > tolerance) open.push_back(i);
+        }
+        if (open.empty() || round >= opts.refine_rounds) break;
+
+        // {splitter, key} pairs drawn evenly from the local part of every
+        // open bracket.
+        std::vector<char> local_samples;
+        for (int i : open) {
+            long long a = local_rank_of(local_data, rank_offset, lo[i]);
+            long long b = local_rank_of(local_data, rank_offset, hi[i]);
+            long long width = b - a;
+            long long take = std::min<long long>(per_bracket, width);
+            for (long long s = 0; s < take; ++s) {
+                long long j = a + (2 * s + 1) * width / (2 * take);
+                pack_pod(i, local_samples);
+                pack_key(make_split_key(local_data[j], rank_offset + j), local_samples);
+            }
+        }
+        std::vector<char> all_samples = gather_bytes(local_samples, 0, comm);
+
+        // Rank 0 interpolates inside each bracket: the target's relative
+        // position between lo_rank and hi_rank picks the sample to try.
+        std::vector<char> next;
+        if (rank == 0) {
+            std::vector<std::vector<SplitKey<T>>> per_splitter(num_splitters);
+            const char* p = all_samples.data();
+            const char* end = p + all_samples.size();
+            while (p < end) {
+                int i = unpack_pod<int>(p);
+                per_splitter[i].push_back(unpack_key<T>(p));
+            }
+            for (int i : open) {
+                std::vector<SplitKey<T>>& keys = per_splitter[i];
+                if (keys.empty()) continue;
+                std::sort(keys.begin(), keys.end());
+                long long target = static_cast<long long>(i + 1) * N / size;
+                double fraction = hi_rank[i] > lo_rank[i]
+                    ? static_cast<double>(target - lo_rank[i]) / (hi_rank[i] - lo_rank[i]) : 0.5;
+                long long m = keys.size();
+                long long centre = std::min(m - 1, static_cast<long long>(fraction * m));
+                long long first = std::max(0LL, centre - per_bracket / 2);
+                long long last = std::min(m, first + per_bracket);
+                for (long long k = first; k < last; ++k) {
+                    pack_pod(i, next);
+                    pack_key(keys[k], next);
+                }
+            }
+        }
+
+        bcast_bytes(next, 0, comm);
+        if (next.empty()) break;
+
+        candidates.clear();
+        owner.clear();
+        const char* p = next.data();
+        const char* end = p + next.size();
+        while (p < end) {
+            owner.push_back(unpack_pod<int>(p));
+            candidates.push_back(unpack_key<T>(p));
+        }
+    }
+}
+
+// Oversampled regular sampling: each rank contributes up to
+// oversample * p evenly spaced (value, index) keys, rank 0 picks every
+// (total / p)-th key of the sorted sample, and the result is optionally
+// refined by histogramming. Keys travel packed, so the same code serves
+// variable-length elements.
+template<typename T>
+std::vector<SplitKey<T>> select_splitters(const std::vector<T>& local_data, long long rank_offset, long long N,
+                                          const SortOptions& opts, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    long long local_n = local_data.size();
+
+    long long per_rank = std::min<long long>(static_cast<long long>(std::max(1, opts.oversample)) * size, local_n);
+    std::vector<char> samples;
+    for (long long s = 0; s < per_rank; ++s) {
+        long long j = (2 * s + 1) * local_n / (2 * per_rank);
+        pack_key(make_split_key(local_data[j], rank_offset + j), samples);
+    }
+    std::vector<char> gathered_samples = gather_bytes(samples, 0, comm);
+
+    std::vector<char> packed;
+    if (rank == 0) {
+        std::vector<SplitKey<T>> keys = unpack_keys<T>(gathered_samples);
+        std::sort(keys.begin(), keys.end());
+        long long total = keys.size();
+        for (int i = 0; i < size - 1; ++i) {
+            pack_key(total > 0 ? keys[std::min(total - 1, static_cast<long long>(i + 1) * total / size)]
+                               : bound_split_key<T>(1), packed);
+        }
+    }
+    bcast_bytes(packed, 0, comm);
+    std::vector<SplitKey<T>> splitters = unpack_keys<T>(packed);
+
+    if (opts.refine_rounds > 0 && size > 1 && N > 0) {
+        refine_splitters(splitters, local_data, rank_offset, N, opts, comm);
+    }
+    return splitters;
+}
+
+// Local sort for hybrid mode: each thread sorts one chunk, then the chunks
+// are merged with the same threaded multiway merge as the receive phase.
+// With one thread this is just std::sort.
+template<typename T>
+void parallel_local_sort(std::vector<T>& data) {
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = std::max(1, static_cast<int>(std::min<long long>(omp_get_max_threads(), data.size() / 65536)));
+#endif
+    if (num_threads == 1) {
+        std::sort(data.begin(), data.end());
+        return;
+    }
+
+    long long n = data.size();
+    std::vector<Run<T>> runs(num_threads);
+    #pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+    for (int t = 0; t < num_threads; ++t) {
+        long long begin = n * t / num_threads;
+        long long end = n * (t + 1) / num_threads;
+        std::sort(data.begin() + begin, data.begin() + end);
+        runs[t].first = data.data() + begin;
+        runs[t].last = data.data() + end;
+    }
+
+    std::vector<T> merged(n);
+    parallel_multiway_merge(runs, merged.data(), n);
+    data.swap(merged);
+}
+
+// Exchanges per-destination counts and lays out the receive buffer:
+// returns the total and fills recv_counts/recv_displs.
+inline long long exchange_counts(const std::vector<long long>& send_counts, std::vector<long long>& recv_counts,
+                          std::vector<long long>& recv_displs, MPI_Comm comm) {
+    int size;
+    MPI_Comm_size(comm, &size);
+    recv_counts.assign(size, 0);
+    recv_displs.assign(size, 0);
+    MPI_Alltoall(send_counts.data(), 1, MPI_LONG_LONG, recv_counts.data(), 1, MPI_LONG_LONG, comm);
+    long long total_recv = 0;
+    for (int i = 0; i < size; ++i) {
+        recv_displs[i] = total_recv;
+        total_recv += recv_counts[i];
+    }
+    return total_recv;
+}
+
+// Pipelined all-to-all: every bucket is cut into chunks of at most
+// opts.chunk_elems elements of `type`, and chunk round r is posted as
+// Isend/Irecv pairs while up to opts.pipeline_depth - 1 earlier rounds are
+// still in flight. Each time the oldest round lands, on_round(received,
+// final) is told how many elements of every source have arrived, so the
+// caller can work on them while later rounds are in progress. Counts and
+// offsets are 64-bit; a single message never exceeds chunk_elems, which
+// fits an int.
+template<typename Elem, typename OnRound>
+void pipelined_alltoallv(const Elem* send, const std::vector<long long>& send_counts,
+                         const std::vector<long long>& send_displs, Elem* recv,
+                         const std::vector<long long>& recv_counts, const std::vector<long long>& recv_displs,
+                         MPI_Datatype type, const SortOptions& opts, OnRound on_round, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    const long long chunk = std::max(1LL, std::min<long long>(opts.chunk_elems, std::numeric_limits<int>::max()));
+    long long rounds = 0;
+    for (int i = 0; i < size; ++i) {
+        rounds = std::max(rounds, (send_counts[i] + chunk - 1) / chunk);
+        rounds = std::max(rounds, (recv_counts[i] + chunk - 1) / chunk);
+    }
+    const long long depth = std::max(1, opts.pipeline_depth);
+
+    std::vector<long long> received(size, 0); // completed prefix per source
+    std::vector<std::vector<MPI_Request>> requests(rounds);
+
+    auto complete_round = [&](long long r) {
+        MPI_Waitall(static_cast<int>(requests[r].size()), requests[r].data(), MPI_STATUSES_IGNORE);
+        requests[r].clear();
+        for (int s = 0; s < size; ++s) {
+            received[s] = std::min(recv_counts[s], (r + 1) * chunk);
+        }
+        on_round(received, r == rounds - 1);
+    };
+
+    for (long long r = 0; r < rounds; ++r) {
+        // Peers are visited in a rotated order so no rank is everyone's
+        // first target.
+        for (int k = 0; k < size; ++k) {
+            int src = (rank - k + size) % size;
+            long long offset = r * chunk;
+            if (offset < recv_counts[src]) {
+                MPI_Request request;
+                int count = static_cast<int>(std::min(chunk, recv_counts[src] - offset));
+                MPI_Irecv(recv + recv_displs[src] + offset, count, type, src, 0, comm, &request);
+                requests[r].push_back(request);
+            }
+        }
+        for (int k = 0; k < size; ++k) {
+            int dest = (rank + k) % size;
+            long long offset = r * chunk;
+            if (offset < send_counts[dest]) {
+                MPI_Request request;
+                int count = static_cast<int>(std::min(chunk, send_counts[dest] - offset));
+                MPI_Isend(send + send_displs[dest] + offset, count, type, dest, 0, comm, &request);
+                requests[r].push_back(request);
+            }
+        }
+        if (r - depth + 1 >= 0) complete_round(r - depth + 1);
+    }
+    for (long long r = std::max(0LL, rounds - depth + 1); r < rounds; ++r) {
+        complete_round(r);
+    }
+    if (rounds == 0) on_round(received, true);
+}
+
+// Exchange for fixed-size elements, which move as SortTraits<T>::datatype()
+// straight out of the sorted local data. Whenever a round lands,
+// everything that can no longer be preceded by an unreceived element is
+// merged into `out`, so merging overlaps the transfers still in progress.
+template<typename T>
+void exchange_merge(const std::vector<T>& local_data, const std::vector<long long>& send_counts,
+                    const std::vector<long long>& send_displs, const SortOptions& opts, std::vector<T>& out,
+                    MPI_Comm comm) {
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    std::vector<long long> recv_counts, recv_displs;
+    long long total_recv = exchange_counts(send_counts, recv_counts, recv_displs, comm);
+    std::vector<T> recv_buffer(total_recv);
+    out.resize(total_recv);
+
+    std::vector<long long> merged_upto(size, 0);
+    long long emitted = 0;
+
+    // Merges the part of every run below the frontier: the smallest last-
+    // received value over sources that still have data in flight. Nothing
+    // arriving later can be smaller than that.
+    auto merge_available = [&](const std::vector<long long>& received, bool final_round) {
+        const T* frontier = nullptr;
+        for (int s = 0; s < size && !final_round; ++s) {
+            if (received[s] == recv_counts[s]) continue;
+            if (received[s] == 0) return; // no lower bound on this source yet
+            const T* last = &recv_buffer[recv_displs[s] + received[s] - 1];
+            if (frontier == nullptr || *last < *frontier) frontier = last;
+        }
+        std::vector<Run<T>> runs(size);
+        long long count = 0;
+        for (int s = 0; s < size; ++s) {
+            const T* base = recv_buffer.data() + recv_displs[s];
+            long long cut = received[s];
+            if (frontier != nullptr) {
+                cut = merged_upto[s] + branchless_lower_bound(base + merged_upto[s], received[s] - merged_upto[s],
+                                                             [frontier](const T& x) { return x < *frontier; });
+            }
+            runs[s].first = base + merged_upto[s];
+            runs[s].last = base + cut;
+            count += cut - merged_upto[s];
+            merged_upto[s] = cut;
+        }
+        if (count == 0) return;
+        parallel_multiway_merge(runs, out.data() + emitted, count);
+        emitted += count;
+    };
+
+    pipelined_alltoallv(local_data.data(), send_counts, send_displs, recv_buffer.data(), recv_counts, recv_displs,
+                        SortTraits<T>::datatype(), opts, merge_available, comm);
+}
+
+// Exchange for strings: every bucket is packed as length-prefixed bytes
+// and the bytes go through the same pipelined exchange (the chunk limit is
+// then in bytes). A chunk boundary can split a string, so the runs are
+// unpacked and LCP-merged once everything has arrived.
+inline void exchange_merge(const std::vector<std::string>& local_data, const std::vector<long long>& send_counts,
+                    const std::vector<long long>& send_displs, const SortOptions& opts,
+                    std::vector<std::string>& out, MPI_Comm comm) {
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    std::vector<char> send_bytes;
+    std::vector<long long> byte_counts(size), byte_displs(size);
+    for (int i = 0; i < size; ++i) {
+        byte_displs[i] = send_bytes.size();
+        for (long long j = send_displs[i]; j < send_displs[i] + send_counts[i]; ++j) {
+            SortTraits<std::string>::pack(local_data[j], send_bytes);
+        }
+        byte_counts[i] = send_bytes.size() - byte_displs[i];
+    }
+
+    std::vector<long long> recv_counts, recv_displs;
+    long long total_bytes = exchange_counts(byte_counts, recv_counts, recv_displs, comm);
+    std::vector<char> recv_bytes(total_bytes);
+    pipelined_alltoallv(send_bytes.data(), byte_counts, byte_displs, recv_bytes.data(), recv_counts, recv_displs,
+                        MPI_BYTE, opts, [](const std::vector<long long>&, bool) {}, comm);
+    std::vector<char>().swap(send_bytes);
+
+    std::vector<std::string> received;
+    std::vector<long long> run_begin(size + 1, 0);
+    for (int s = 0; s < size; ++s) {
+        run_begin[s] = received.size();
+        const char* p = recv_bytes.data() + recv_displs[s];
+        const char* end = p + recv_counts[s];
+        while (p < end) received.push_back(SortTraits<std::string>::unpack(p));
+    }
+    run_begin[size] = received.size();
+    std::vector<char>().swap(recv_bytes);
+
+    std::vector<Run<std::string>> runs(size);
+    for (int s = 0; s < size; ++s) {
+        runs[s].first = received.data() + run_begin[s];
+        runs[s].last = received.data() + run_begin[s + 1];
+    }
+    out.resize(received.size());
+    parallel_multiway_merge(runs, out.data(), out.size());
+}
+
+// Bytes in a block, the declared traffic of one pass over it for the perf
+// regions (only walked for variable-length types, and only when enabled).
+template<typename T>
+double data_bytes(const std::vector<T>& data) {
+    if (!perf::enabled) return 0.0;
+    if (SortTraits<T>::fixed_size) return static_cast<double>(data.size()) * sizeof(T);
+    double bytes = 0.0;
+    for (size_t i = 0; i < data.size(); ++i) bytes += SortTraits<T>::bytes(data[i]);
+    return bytes;
+}
+
+// Sample sort on already-distributed data. On return each rank holds its
+// sorted slice, and slices are globally ordered by rank.
+template<typename T>
+std::vector<T> parallel_sample_sort(std::vector<T>& local_data, const SortOptions& opts, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    long long local_n = local_data.size();
+    double local_bytes = data_bytes(local_data);
+    double log_n = std::log2(std::max(2.0, static_cast<double>(local_n)));
+
+    {
+        perf::Region region("Local sort", local_n * log_n, 2 * local_bytes);
+        parallel_local_sort(local_data);
+    }
+
+    long long rank_offset = 0;
+    long long N = 0;
+    MPI_Exscan(&local_n, &rank_offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) rank_offset = 0;
+    MPI_Allreduce(&local_n, &N, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+    std::vector<SplitKey<T>> splitters;
+    {
+        perf::Region region("Select splitters", (size - 1.0) * opts.oversample * log_n, 0.0);
+        splitters = select_splitters(local_data, rank_offset, N, opts, comm);
+    }
+
+    // Bucket boundaries come from p - 1 binary searches over the sorted
+    // local data, and the exchange reads the buckets straight out of it.
+    std::vector<long long> send_counts(size, 0);
+    std::vector<long long> send_displs(size, 0);
+    long long bucket_begin = 0;
+    for (int i = 0; i < size; ++i) {
+        long long bucket_end = i < size - 1 ? local_rank_of(local_data, rank_offset, splitters[i]) : local_n;
+        bucket_end = std::max(bucket_end, bucket_begin);
+        send_displs[i] = bucket_begin;
+        send_counts[i] = bucket_end - bucket_begin;
+        bucket_begin = bucket_end;
+    }
+
+    // What arrives is p sorted runs, one per sender: merge, don't re-sort.
+    // Declared work assumes a balanced exchange: every byte is sent,
+    // received, read by the merge and written once more.
+    std::vector<T> merged;
+    {
+        perf::Region region("Exchange + merge", local_n * std::log2(std::max(2, size)), 4 * local_bytes);
+        exchange_merge(local_data, send_counts, send_displs, opts, merged, comm);
+    }
+    return merged;
+}
+
+// Counters for the selection benchmark.
+struct SelectStats {
+    int rounds = 0;
+    long long bytes = 0; // bytes this rank sent or received in selection collectives
+};
+
+// A slice of the global order that still holds unresolved targets. Every
+// rank keeps its part of it in work[begin, end); global_base elements
+// are ordered before it, and global_size elements are in it.
+struct SelectSegment {
+    long long begin;
+    long long end;
+    long long global_base;
+    long long global_size;
+    std::vector<int> targets; // indices into ks
+};
+
+// Classifies data[0, n) into 2q + 1 buckets around q sorted pivots:
+// < p0, == p0, (p0, p1), == p1, ..., > p(q-1). Writes each element's bucket
+// to ids and appends the bucket sizes to counts.
+template<typename T>
+void classify_by_pivots(const T* data, long long n, const std::vector<T>& pivots, std::vector<int>& ids,
+                        std::vector<long long>& counts) {
+    int q = pivots.size();
+    size_t first = counts.size();
+    counts.resize(first + 2 * q + 1, 0);
+    ids.resize(n);
+    for (long long i = 0; i < n; ++i) {
+        const T& x = data[i];
+        long long j = branchless_lower_bound(pivots.data(), q, [&x](const T& p) { return p < x; });
+        int b = 2 * j + (j < q && !(x < pivots[j]) ? 1 : 0);
+        ids[i] = b;
+        ++counts[first + b];
+    }
+}
+
+// Distributed selection: the elements of global ranks ks (0-based, each in
+// [0, N)) of the unsorted distributed array, returned on every rank. Works
+// like a batched quickselect. Each round:
+//   - every rank sends rank 0 up to oversample * p random elements from
+//     its part of each unresolved segment;
+//   - rank 0 brackets every target with two pivots from the sorted sample,
+//     about sqrt(sample) positions either side of where it should fall, and
+//     broadcasts them;
+//   - every rank classifies its part of the segment against the pivots,
+//     and one MPI_Allreduce of the bucket sizes tells everybody which
+//     bucket holds each target;
+//   - only the buckets that still hold targets are copied forward.
+// A target landing in a "== pivot" bucket is resolved. Once a segment is
+// small enough to be sampled completely, rank 0 reads its targets straight
+// off the sample. Only samples, pivots and counts cross the network. Each
+// round keeps roughly 2 / sqrt(sample) of every segment, so O(log N)
+// rounds are enough. The input is read once and never copied whole; later
+// rounds touch only the survivors.
+template<typename T>
+std::vector<T> distributed_select(const std::vector<T>& local_data, const std::vector<long long>& ks,
+                                  const SortOptions& opts, MPI_Comm comm, SelectStats* stats = nullptr) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    SelectStats local_stats;
+    SelectStats& st = stats != nullptr ? *stats : local_stats;
+    st = SelectStats();
+
+    // Round one reads local_data directly; after that `work` holds the
+    // surviving segments back to back.
+    std::vector<T> work;
+    const std::vector<T>* source = &local_data;
+    std::vector<T> answers(ks.size());
+    long long local_n = local_data.size();
+    long long N = 0;
+    MPI_Allreduce(&local_n, &N, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+    std::vector<SelectSegment> segments(1);
+    segments[0].begin = 0;
+    segments[0].end = local_n;
+    segments[0].global_base = 0;
+    segments[0].global_size = N;
+    for (size_t t = 0; t < ks.size(); ++t) {
+        if (ks[t] >= 0 && ks[t] < N) segments[0].targets.push_back(t);
+    }
+    if (segments[0].targets.empty()) segments.clear();
+
+    const long long per_rank = static_cast<long long>(std::max(1, opts.oversample)) * size;
+    std::mt19937_64 gen(12345 + rank);
+
+    while (!segments.empty()) {
+        ++st.rounds;
+
+        // {segment, element} pairs. A part no larger than per_rank is sent
+        // whole, so rank 0 can tell when it has seen a complete segment.
+        std::vector<char> samples;
+        for (size_t s = 0; s < segments.size(); ++s) {
+            long long n = segments[s].end - segments[s].begin;
+            long long take = std::min(per_rank, n);
+            for (long long i = 0; i < take; ++i) {
+                long long j = take == n ? i : static_cast<long long>(gen() % n);
+                pack_pod(static_cast<int>(s), samples);
+                SortTraits<T>::pack((*source)[segments[s].begin + j], samples);
+            }
+        }
+        std::vector<char> gathered = gather_bytes(samples, 0, comm);
+        st.bytes += samples.size() + gathered.size();
+
+        // Per segment: -1 and the answers when it was sampled completely,
+        // otherwise the pivot count and the pivots.
+        std::vector<char> plan;
+        if (rank == 0) {
+            std::vector<std::vector<T>> per_segment(segments.size());
+            const char* p = gathered.data();
+            const char* end = p + gathered.size();
+            while (p < end) {
+                int s = unpack_pod<int>(p);
+                per_segment[s].push_back(SortTraits<T>::unpack(p));
+            }
+            for (size_t s = 0; s < segments.size(); ++s) {
+                const SelectSegment& seg = segments[s];
+                std::vector<T>& sample = per_segment[s];
+                std::sort(sample.begin(), sample.end());
+                long long m = sample.size();
+                if (m == seg.global_size) {
+                    pack_pod(-1, plan);
+                    for (int t : seg.targets) SortTraits<T>::pack(sample[ks[t] - seg.global_base], plan);
+                    continue;
+                }
+                long long margin = std::max(1LL, static_cast<long long>(std::sqrt(static_cast<double>(m))));
+                std::vector<T> pivots;
+                for (int t : seg.targets) {
+                    long long pos = static_cast<long long>(
+                        static_cast<double>(ks[t] - seg.global_base) / seg.global_size * m);
+                    pivots.push_back(sample[std::max(0LL, pos - margin)]);
+                    pivots.push_back(sample[std::min(m - 1, pos + margin)]);
+                }
+                std::sort(pivots.begin(), pivots.end());
+                pivots.erase(std::unique(pivots.begin(), pivots.end(),
+                                         [](const T& a, const T& b) { return !(a < b) && !(b < a); }),
+                             pivots.end());
+                pack_pod(static_cast<int>(pivots.size()), plan);
+                for (size_t i = 0; i < pivots.size(); ++i) SortTraits<T>::pack(pivots[i], plan);
+            }
+        }
+        bcast_bytes(plan, 0, comm);
+        st.bytes += plan.size();
+
+        std::vector<std::vector<T>> seg_pivots(segments.size());
+        std::vector<std::vector<int>> seg_ids(segments.size());
+        std::vector<size_t> count_offset(segments.size());
+        std::vector<long long> local_counts;
+        const char* p = plan.data();
+        for (size_t s = 0; s < segments.size(); ++s) {
+            int q = unpack_pod<int>(p);
+            if (q < 0) {
+                for (int t : segments[s].targets) answers[t] = SortTraits<T>::unpack(p);
+                continue;
+            }
+            for (int i = 0; i < q; ++i) seg_pivots[s].push_back(SortTraits<T>::unpack(p));
+            count_offset[s] = local_counts.size();
+            classify_by_pivots(source->data() + segments[s].begin, segments[s].end - segments[s].begin,
+                               seg_pivots[s], seg_ids[s], local_counts);
+        }
+        std::vector<long long> global_counts(local_counts.size());
+        MPI_Allreduce(local_counts.data(), global_counts.data(), static_cast<int>(local_counts.size()),
+                      MPI_LONG_LONG, MPI_SUM, comm);
+        st.bytes += 2 * local_counts.size() * sizeof(long long);
+
+        // Buckets that still hold targets become the next segments; their
+        // elements are copied into the next work array in bucket order.
+        std::vector<SelectSegment> next;
+        std::vector<T> next_work;
+        for (size_t s = 0; s < segments.size(); ++s) {
+            const std::vector<T>& pivots = seg_pivots[s];
+            if (pivots.empty()) continue;
+            int buckets = 2 * pivots.size() + 1;
+            std::vector<long long> dest(buckets, -1);
+            long long global_pos = segments[s].global_base;
+            for (int b = 0; b < buckets; ++b) {
+                SelectSegment child;
+                child.global_base = global_pos;
+                child.global_size = global_counts[count_offset[s] + b];
+                for (int t : segments[s].targets) {
+                    if (ks[t] < global_pos || ks[t] >= global_pos + child.global_size) continue;
+                    if (b % 2 == 1) {
+                        answers[t] = pivots[b / 2];
+                    } else {
+                        child.targets.push_back(t);
+                    }
+                }
+                global_pos += child.global_size;
+                if (child.targets.empty()) continue;
+                child.begin = next_work.size();
+                child.end = child.begin + local_counts[count_offset[s] + b];
+                dest[b] = child.begin;
+                next_work.resize(child.end);
+                next.push_back(child);
+            }
+            const T* data = source->data() + segments[s].begin;
+            const std::vector<int>& ids = seg_ids[s];
+            for (size_t i = 0; i < ids.size(); ++i) {
+                if (dest[ids[i]] >= 0) next_work[dest[ids[i]]++] = data[i];
+            }
+        }
+        work.swap(next_work);
+        source = &work;
+        segments.swap(next);
+    }
+    return answers;
+}
+
+// The k largest elements, left on the ranks that hold them: returns this
+// rank's share. One selection finds the threshold (the element of rank
+// N - k); everything above it is kept, and ties at the threshold are
+// handed out in rank order until exactly k are kept.
+template<typename T>
+std::vector<T> distributed_top_k(const std::vector<T>& local_data, long long k, const SortOptions& opts,
+                                 MPI_Comm comm, SelectStats* stats = nullptr) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    long long local_n = local_data.size();
+    long long N = 0;
+    MPI_Allreduce(&local_n, &N, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    k = std::min(std::max(k, 0LL), N);
+    std::vector<T> top;
+    if (k == 0) return top;
+
+    T threshold = distributed_select(local_data, std::vector<long long>(1, N - k), opts, comm, stats)[0];
+    long long equal = 0;
+    for (size_t i = 0; i < local_data.size(); ++i) {
+        if (threshold < local_data[i]) {
+            top.push_back(local_data[i]);
+        } else if (!(local_data[i] < threshold)) {
+            ++equal;
+        }
+    }
+
+    long long greater = top.size(), total_greater = 0, equal_before = 0;
+    MPI_Allreduce(&greater, &total_greater, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    MPI_Exscan(&equal, &equal_before, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) equal_before = 0;
+    long long take = std::min(equal, std::max(0LL, k - total_greater - equal_before));
+    for (size_t i = 0; i < local_data.size() && take > 0; ++i) {
+        if (!(local_data[i] < threshold) && !(threshold < local_data[i])) {
+            top.push_back(local_data[i]);
+            --take;
+        }
+    }
+    return top;
+}
+
+// Sort-then-index baseline: the elements of global ranks ks in a sorted
+// distribution, fetched from the ranks that own them.
+template<typename T>
+std::vector<T> index_sorted(const std::vector<T>& local_sorted, const std::vector<long long>& ks, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    long long local_n = local_sorted.size();
+    long long offset = 0;
+    MPI_Exscan(&local_n, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) offset = 0;
+
+    std::vector<char> owned;
+    for (size_t t = 0; t < ks.size(); ++t) {
+        if (ks[t] >= offset && ks[t] < offset + local_n) {
+            pack_pod(static_cast<int>(t), owned);
+            SortTraits<T>::pack(local_sorted[ks[t] - offset], owned);
+        }
+    }
+    std::vector<char> all = allgather_bytes(owned, comm);
+    std::vector<T> answers(ks.size());
+    const char* p = all.data();
+    const char* end = p + all.size();
+    while (p < end) {
+        int t = unpack_pod<int>(p);
+        answers[t] = SortTraits<T>::unpack(p);
+    }
+    return answers;
+}
+
+// Order-independent fingerprint of a distributed multiset: the wrapping sum
+// of the mixed element hashes over all ranks. Take it of the input before
+// sorting and pass it to verify_distributed_sorted. Collective.
+template<typename T>
+uint64_t distributed_checksum(const std::vector<T>& local_data, MPI_Comm comm) {
+    uint64_t local = 0;
+    for (size_t i = 0; i < local_data.size(); ++i) local += mix64(SortTraits<T>::hash(local_data[i]));
+    uint64_t total = 0;
+    MPI_Allreduce(&local, &total, 1, MPI_UINT64_T, MPI_SUM, comm);
+    return total;
+}
+
+// Checks a distributed result without moving it: every slice must be
+// locally sorted, each rank's first element must not be smaller than the
+// last element of the nearest non-empty rank before it, the element count
+// must be preserved, and the checksum must match the input's, so elements
+// cannot have been lost, duplicated or rewritten. Records also have their
+// payload checked. Collective; returns the same answer on all ranks.
+template<typename T>
+bool verify_distributed_sorted(const std::vector<T>& local_sorted, long long expected_N, uint64_t expected_checksum,
+                               MPI_Comm comm) {
+    int ok = sequential::is_sorted(local_sorted) ? 1 : 0;
+    for (size_t i = 0; i < local_sorted.size() && ok; ++i) {
+        if (!SortTraits<T>::valid(local_sorted[i])) ok = 0;
+    }
+
+    // {count, first, last} per rank; p small records is cheap even for p in the hundreds.
+    std::vector<char> boundary;
+    pack_pod(static_cast<long long>(local_sorted.size()), boundary);
+    if (!local_sorted.empty()) {
+        SortTraits<T>::pack(local_sorted.front(), boundary);
+        SortTraits<T>::pack(local_sorted.back(), boundary);
+    }
+    std::vector<char> boundaries = allgather_bytes(boundary, comm);
+
+    long long total = 0;
+    bool have_prev = false;
+    T prev_last = T();
+    const char* p = boundaries.data();
+    const char* end = p + boundaries.size();
+    while (p < end) {
+        long long count = unpack_pod<long long>(p);
+        total += count;
+        if (count == 0) continue;
+        T first = SortTraits<T>::unpack(p);
+        T last = SortTraits<T>::unpack(p);
+        if (have_prev && first < prev_last) ok = 0;
+        prev_last = last;
+        have_prev = true;
+    }
+    if (total != expected_N) ok = 0;
+    if (distributed_checksum(local_sorted, comm) != expected_checksum) ok = 0;
+
+    int all_ok;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_MIN, comm);
+    return all_ok != 0;
+}
+
+// Each rank reads its block of a raw binary file of native elements
+// (fixed-size types only) with collective calls, so no rank ever holds
+// more than its share.
+template<typename T>
+std::vector<T> read_input_file(const std::string& path, long long& N, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    MPI_File fh;
+    if (MPI_File_open(comm, path.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (rank == 0) std::cerr << "Cannot open input file " << path << std::endl;
+        MPI_Abort(comm, 1);
+    }
+    MPI_Offset file_bytes;
+    MPI_File_get_size(fh, &file_bytes);
+    N = file_bytes / static_cast<MPI_Offset>(sizeof(T));
+
+    long long offset, count;
+    block_range(N, size, rank, offset, count);
+    std::vector<T> local_data(count);
+    int blocks = static_cast<int>(count / LARGE_BLOCK);
+    int rest = static_cast<int>(count % LARGE_BLOCK);
+    MPI_Offset byte_offset = offset * static_cast<MPI_Offset>(sizeof(T));
+    MPI_File_read_at_all(fh, byte_offset, local_data.data(), blocks, large_block_type<T>(), MPI_STATUS_IGNORE);
+    MPI_File_read_at_all(fh, byte_offset + blocks * LARGE_BLOCK * static_cast<MPI_Offset>(sizeof(T)),
+                         local_data.data() + blocks * LARGE_BLOCK, rest, SortTraits<T>::datatype(),
+                         MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+    return local_data;
+}
+
+// Writes the globally ordered slices back-to-back. A rank's file offset is
+// the number of elements on lower ranks, obtained with MPI_Exscan.
+template<typename T>
+void write_output_file(const std::string& path, const std::vector<T>& local_sorted, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    long long local_count = local_sorted.size();
+    long long offset = 0;
+    MPI_Exscan(&local_count, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) offset = 0; // MPI_Exscan leaves rank 0's result undefined
+
+    MPI_File fh;
+    if (MPI_File_open(comm, path.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (rank == 0) std::cerr << "Cannot open output file " << path << std::endl;
+        MPI_Abort(comm, 1);
+    }
+    MPI_File_set_size(fh, 0);
+    int blocks = static_cast<int>(local_count / LARGE_BLOCK);
+    int rest = static_cast<int>(local_count % LARGE_BLOCK);
+    MPI_Offset byte_offset = offset * static_cast<MPI_Offset>(sizeof(T));
+    MPI_File_write_at_all(fh, byte_offset, local_sorted.data(), blocks, large_block_type<T>(), MPI_STATUS_IGNORE);
+    MPI_File_write_at_all(fh, byte_offset + blocks * LARGE_BLOCK * static_cast<MPI_Offset>(sizeof(T)),
+                          local_sorted.data() + blocks * LARGE_BLOCK, rest, SortTraits<T>::datatype(),
+                          MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+}
+
+// Fills `out` with one of the benchmark input distributions:
+//   uniform - values in [1, min(10 N, INT_MAX)], almost no duplicates
+//   dups    - only 16 distinct values, long runs of equal keys
+//   skewed  - exponential, most values packed near zero with a long tail
+inline void fill_random(std::vector<int>& out, long long N, const std::string& distribution, std::mt19937& gen) {
+    if (distribution == "dups") {
+        std::uniform_int_distribution<> distrib(1, 16);
+        for (size_t i = 0; i < out.size(); ++i) out[i] = distrib(gen);
+    } else if (distribution == "skewed") {
+        std::exponential_distribution<> distrib(1.0);
+        for (size_t i = 0; i < out.size(); ++i) out[i] = static_cast<int>(distrib(gen) * 1000.0);
+    } else {
+        long long max_value = std::min<long long>(N * 10, std::numeric_limits<int>::max());
+        std::uniform_int_distribution<> distrib(1, static_cast<int>(std::max(1LL, max_value)));
+        for (size_t i = 0; i < out.size(); ++i) out[i] = distrib(gen);
+    }
+}
+
+// Records use the same key distributions over 64-bit keys (uniform draws
+// from the whole range).
+inline void fill_random(std::vector<Record>& out, long long, const std::string& distribution, std::mt19937& gen) {
+    std::uniform_int_distribution<uint64_t> uniform;
+    std::uniform_int_distribution<uint64_t> dups(1, 16);
+    std::exponential_distribution<> skewed(1.0);
+    for (size_t i = 0; i < out.size(); ++i) {
+        uint64_t key = distribution == "dups" ? dups(gen)
+                     : distribution == "skewed" ? static_cast<uint64_t>(skewed(gen) * 1000.0) : uniform(gen);
+        out[i] = make_record(key);
+    }
+}
+
+// Strings:
+//   uniform - 8 to 32 random lowercase letters
+//   dups    - one of 16 short words
+//   skewed  - URLs under a handful of long shared prefixes, the case the
+//             LCP merge is for
+inline void fill_random(std::vector<std::string>& out, long long, const std::string& distribution, std::mt19937& gen) {
+    static const char* prefixes[] = {"https://www.example.org/archive/2024/", "https://www.example.org/archive/2025/",
+                                     "https://www.example.org/users/profile/", "https://cdn.example.net/static/img/"};
+    std::uniform_int_distribution<> letter('a', 'z');
+    std::uniform_int_distribution<> length(8, 32);
+    std::uniform_int_distribution<> small(0, 15);
+    std::uniform_int_distribution<> prefix(0, 3);
+    for (size_t i = 0; i < out.size(); ++i) {
+        std::string& s = out[i];
+        if (distribution == "dups") {
+            s = "word" + std::to_string(small(gen));
+            continue;
+        }
+        s = distribution == "skewed" ? prefixes[prefix(gen)] : "";
+        int n = distribution == "skewed" ? 12 : length(gen);
+        for (int j = 0; j < n; ++j) s.push_back(static_cast<char>(letter(gen)));
+    }
+}
+
+// Generates this rank's block of the global input locally, seeded by rank,
+// so large inputs never exist on a single process.
+template<typename T>
+std::vector<T> generate_local_block(long long N, const std::string& distribution, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    long long offset, count;
+    block_range(N, size, rank, offset, count);
+    std::vector<T> local_data(count);
+    std::mt19937 gen(std::random_device{}() + rank);
+    fill_random(local_data, N, distribution, gen);
+    return local_data;
+}
@@ -0,0 +1,332 @@
+#include "sorting.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <omp.h>
+
+using namespace std;
+
+SortingBenchmark::SortingBenchmark(const vector<int>& arraySizes, int runs, int threads, bool pinThreads)
+    : sizes(arraySizes), numRuns(runs), pool(threads > 0 ? threads : omp_get_max_threads(), pinThreads) {}
+
+vector<int> SortingBenchmark::generateRandomArray(int size, int min, int max) {
+    vector<int> arr(size);
+    random_device rd;
+    mt19937 gen(rd());
+    uniform_int_distribution<> distrib(min, max);
+    
+    for (int i = 0; i < size; i++) {
+        arr[i] = distrib(gen);
+    }
+    
+    return arr;
+}
+
+bool SortingBenchmark::isSorted(const vector<int>& arr) {
+    for (size_t i = 1; i < arr.size(); i++) {
+        if (arr[i - 1] > arr[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SortingBenchmark::sequentialBubbleSort(vector<int>& arr) {
+    int n = arr.size();
+    for (int i = 0; i < n - 1; i++) {
+        for (int j = 0; j < n - i - 1; j++) {
+            if (arr[j] > arr[j + 1]) {
+                swap(arr[j], arr[j + 1]);
+            }
+        }
+    }
+}
+
+void SortingBenchmark::parallelBubbleSort(vector<int>& arr) {
+    int n = arr.size();
+    
+    for (int phase = 0; phase < n; phase++) {
+        if (phase % 2 == 0) {
+            #pragma omp parallel for
+            for (int i = 1; i < n - 1; i += 2) {
+                if (arr[i] > arr[i + 1]) {
+                    swap(arr[i], arr[i + 1]);
+                }
+            }
+        } else {
+            #pragma omp parallel for
+            for (int i = 0; i < n - 1; i += 2) {
+                if (arr[i] > arr[i + 1]) {
+                    swap(arr[i], arr[i + 1]);
+                }
+            }
+        }
+    }
+}
+
+void SortingBenchmark::workStealingBubbleSort(vector<int>& arr) {
+    int n = arr.size();
+
+    for (int phase = 0; phase < n; phase++) {
+        int first = phase % 2 == 0 ? 1 : 0;
+        long pairs = (n - first) / 2;
+        pool.parallelFor(0, pairs, BUBBLE_GRAIN, [&arr, first](long lo, long hi) {
+            for (long p = lo; p < hi; p++) {
+                int i = first + 2 * p;
+                if (arr[i] > arr[i + 1]) {
+                    swap(arr[i], arr[i + 1]);
+                }
+            }
+        });
+    }
+}
+
+void SortingBenchmark::sequentialMerge(vector<int>& arr, vector<int>& temp, int left, int mid, int right) {
+    int i = left;
+    int j = mid + 1;
+    int k = left;
+    
+    while (i <= mid && j <= right) {
+        if (arr[i] <= arr[j]) {
+            temp[k++] = arr[i++];
+        } else {
+            temp[k++] = arr[j++];
+        }
+    }
+    
+    while (i <= mid) {
+        temp[k++] = arr[i++];
+    }
+    
+    while (j <= right) {
+        temp[k++] = arr[j++];
+    }
+    
+    for (i = left; i <= right; i++) {
+        arr[i] = temp[i];
+    }
+}
+
+void SortingBenchmark::sequentialMergeSortHelper(vector<int>& arr, vector<int>& temp, int left, int right) {
+    if (left < right) {
+        int mid = left + (right - left) / 2;
+        
+        sequentialMergeSortHelper(arr, temp, left, mid);
+        sequentialMergeSortHelper(arr, temp, mid + 1, right);
+        
+        sequentialMerge(arr, temp, left, mid, right);
+    }
+}
+
+void SortingBenchmark::sequentialMergeSort(vector<int>& arr) {
+    vector<int> temp(arr.size());
+    sequentialMergeSortHelper(arr, temp, 0, arr.size() - 1);
+}
+
+void SortingBenchmark::parallelMergeSortHelper(vector<int>& arr, vector<int>& temp, int left, int right, int depth) {
+    if (left < right) {
+        int mid = left + (right - left) / 2;
+        
+        if (depth < 2) {
+            #pragma omp task shared(arr, temp)
+            {
+                parallelMergeSortHelper(arr, temp, left, mid, depth + 1);
+            }
+            
+            #pragma omp task shared(arr, temp)
+            {
+                parallelMergeSortHelper(arr, temp, mid + 1, right, depth + 1);
+            }
+            
+            #pragma omp taskwait
+        } else {
+            sequentialMergeSortHelper(arr, temp, left, mid);
+            sequentialMergeSortHelper(arr, temp, mid + 1, right);
+        }
+        
+        #pragma omp critical
+        {
+            sequentialMerge(arr, temp, left, mid, right);
+        }
+    }
+}
+
+void SortingBenchmark::parallelMergeSort(vector<int>& arr) {
+    vector<int> temp(arr.size());
+    
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            parallelMergeSortHelper(arr, temp, 0, arr.size() - 1);
+        }
+    }
+}
+
+void SortingBenchmark::workStealingMergeSortHelper(vector<int>& arr, vector<int>& temp, int left, int right) {
+    if (right - left < MERGE_GRAIN) {
+        sequentialMergeSortHelper(arr, temp, left, right);
+        return;
+    }
+    int mid = left + (right - left) / 2;
+
+    ws::TaskGroup group(pool);
+    group.spawn([this, &arr, &temp, left, mid] { workStealingMergeSortHelper(arr, temp, left, mid); });
+    workStealingMergeSortHelper(arr, temp, mid + 1, right);
+    group.sync();
+
+    sequentialMerge(arr, temp, left, mid, right);
+}
+
+void SortingBenchmark::workStealingMergeSort(vector<int>& arr) {
+    vector<int> temp(arr.size());
+    workStealingMergeSortHelper(arr, temp, 0, arr.size() - 1);
+}
+
+void SortingBenchmark::runOverheadBenchmark() {
+    const int forkJoins = 20000;
+    const int tasks = 200000;
+    int threads = pool.size();
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int r = 0; r < forkJoins; r++) {
+        #pragma omp parallel for
+        for (int t = 0; t < threads; t++) {
+            asm volatile("");
+        }
+    }
+    chrono::duration<double, micro> ompForkJoin = chrono::high_resolution_clock::now() - start;
+
+    start = chrono::high_resolution_clock::now();
+    for (int r = 0; r < forkJoins; r++) {
+        pool.parallelFor(0, threads, 1, [](long, long) { asm volatile(""); });
+    }
+    chrono::duration<double, micro> wsForkJoin = chrono::high_resolution_clock::now() - start;
+
+    start = chrono::high_resolution_clock::now();
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            for (int t = 0; t < tasks; t++) {
+                #pragma omp task
+                {
+                    asm volatile("");
+                }
+            }
+            #pragma omp taskwait
+        }
+    }
+    chrono::duration<double, nano> ompTasks = chrono::high_resolution_clock::now() - start;
+
+    start = chrono::high_resolution_clock::now();
+    {
+        ws::TaskGroup group(pool);
+        for (int t = 0; t < tasks; t++) {
+            group.spawn([] { asm volatile(""); });
+        }
+        group.sync();
+    }
+    chrono::duration<double, nano> wsTasks = chrono::high_resolution_clock::now() - start;
+
+    cout << "Scheduling overhead (" << threads << " threads)" << endl;
+    cout << "--------------------------------------------" << endl;
+    cout << "| Fork-join, OpenMP       | " << setw(8) << ompForkJoin.count() / forkJoins << " us |" << endl;
+    cout << "| Fork-join, work-stealing| " << setw(8) << wsForkJoin.count() / forkJoins << " us |" << endl;
+    cout << "| Task, OpenMP            | " << setw(8) << ompTasks.count() / tasks << " ns |" << endl;
+    cout << "| Task, work-stealing     | " << setw(8) << wsTasks.count() / tasks << " ns |" << endl;
+    cout << "--------------------------------------------" << endl;
+}
+
+void SortingBenchmark::runBenchmark() {
+    cout << fixed << setprecision(2);
+    cout << "--------------------------------------------" << endl;
+    cout << "| Array Size | Algorithm          | Time (ms) |" << endl;
+    cout << "--------------------------------------------" << endl;
+    
+    for (const auto& size : sizes) {
+        vector<double> seqBubbleTime(numRuns);
+        vector<double> parBubbleTime(numRuns);
+        vector<double> seqMergeTime(numRuns);
+        vector<double> parMergeTime(numRuns);
+        vector<double> wsBubbleTime(numRuns);
+        vector<double> wsMergeTime(numRuns);
+
+        // Declared work: bubble sort compares n^2/2 pairs and streams
+        // the array once per phase; merge sort compares n log n times
+        // and moves each element four times per level (read, write to
+        // temp, read back, write).
+        double n = size;
+        double bubbleOps = n * n / 2;
+        double bubbleBytes = n * n * sizeof(int);
+        double mergeOps = n * log2(n);
+        double mergeBytes = 4 * mergeOps * sizeof(int);
+        
+        for (int run = 0; run < numRuns; run++) {
+            vector<int> arr = generateRandomArray(size, 1, size * 10);
+            
+            vector<int> arr1 = arr;
+            vector<int> arr2 = arr;
+            vector<int> arr3 = arr;
+            vector<int> arr4 = arr;
+            vector<int> arr5 = arr;
+            vector<int> arr6 = arr;
+            
+            seqBubbleTime[run] = measureExecutionTime([this](vector<int>& a) { this->sequentialBubbleSort(a); }, 
+                                                     arr1, "Sequential Bubble Sort", bubbleOps, bubbleBytes);
+            
+            parBubbleTime[run] = measureExecutionTime([this](vector<int>& a) { this->parallelBubbleSort(a); }, 
+                                                     arr2, "Parallel Bubble Sort", bubbleOps, bubbleBytes);
+            
+            seqMergeTime[run] = measureExecutionTime([this](vector<int>& a) { this->sequentialMergeSort(a); }, 
+                                                    arr3, "Sequential Merge Sort", mergeOps, mergeBytes);
+            
+            parMergeTime[run] = measureExecutionTime([this](vector<int>& a) { this->parallelMergeSort(a); }, 
+                                                    arr4, "Parallel Merge Sort", mergeOps, mergeBytes);
+            
+            wsBubbleTime[run] = measureExecutionTime([this](vector<int>& a) { this->workStealingBubbleSort(a); }, 
+                                                    arr5, "Work-Stealing Bubble Sort", bubbleOps, bubbleBytes);
+            
+            wsMergeTime[run] = measureExecutionTime([this](vector<int>& a) { this->workStealingMergeSort(a); }, 
+                                                   arr6, "Work-Stealing Merge Sort", mergeOps, mergeBytes);
+        }
+        
+        double avgSeqBubble = accumulate(seqBubbleTime.begin(), seqBubbleTime.end(), 0.0) / numRuns;
+        double avgParBubble = accumulate(parBubbleTime.begin(), parBubbleTime.end(), 0.0) / numRuns;
+        double avgSeqMerge = accumulate(seqMergeTime.begin(), seqMergeTime.end(), 0.0) / numRuns;
+        double avgParMerge = accumulate(parMergeTime.begin(), parMergeTime.end(), 0.0) / numRuns;
+        double avgWsBubble = accumulate(wsBubbleTime.begin(), wsBubbleTime.end(), 0.0) / numRuns;
+        double avgWsMerge = accumulate(wsMergeTime.begin(), wsMergeTime.end(), 0.0) / numRuns;
+        
+        cout << "| " << setw(10) << size << " | Sequential Bubble | " 
+              << setw(8) << avgSeqBubble << " |" << endl;
+        cout << "| " << setw(10) << size << " | Parallel Bubble   | " 
+              << setw(8) << avgParBubble << " |" << endl;
+        cout << "| " << setw(10) << size << " | Sequential Merge  | " 
+              << setw(8) << avgSeqMerge << " |" << endl;
+        cout << "| " << setw(10) << size << " | Parallel Merge    | " 
+              << setw(8) << avgParMerge << " |" << endl;
+        cout << "| " << setw(10) << size << " | Work-Steal Bubble | " 
+              << setw(8) << avgWsBubble << " |" << endl;
+        cout << "| " << setw(10) << size << " | Work-Steal Merge  | " 
+              << setw(8) << avgWsMerge << " |" << endl;
+        
+        double bubbleSpeedup = avgSeqBubble / avgParBubble;
+        double mergeSpeedup = avgSeqMerge / avgParMerge;
+        double wsBubbleSpeedup = avgSeqBubble / avgWsBubble;
+        double wsMergeSpeedup = avgSeqMerge / avgWsMerge;
+        
+        cout << "| " << setw(10) << size << " | Bubble Speedup    | " 
+              << setw(8) << bubbleSpeedup << "x |" << endl;
+        cout << "| " << setw(10) << size << " | Merge Speedup     | " 
+              << setw(8) << mergeSpeedup << "x |" << endl;
+        cout << "| " << setw(10) << size << " | WS Bubble Speedup | " 
+              << setw(8) << wsBubbleSpeedup << "x |" << endl;
+        cout << "| " << setw(10) << size << " | WS Merge Speedup  | " 
+              << setw(8) << wsMergeSpeedup << "x |" << endl;
+        cout << "--------------------------------------------" << endl;
+    }
+}
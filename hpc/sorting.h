@@ -0,0 +1,84 @@
+// The sorts of practical two: sequential, OpenMP and work-stealing bubble
+// and merge sort, plus the timing table and the scheduling-overhead
+// comparison that two.cpp prints.
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../common/perf_regions.h"
+#include "../common/work_stealing.h"
+
+class SortingBenchmark {
+private:
+    std::vector<int> sizes;
+    int numRuns;
+    ws::Scheduler pool;
+
+    // Work-stealing grain sizes: below these a phase of bubble sort, or a
+    // subarray of merge sort, is cheaper to do on one thread than to split.
+    static const int BUBBLE_GRAIN = 8192;
+    static const int MERGE_GRAIN = 4096;
+    
+    std::vector<int> generateRandomArray(int size, int min, int max);
+    
+    bool isSorted(const std::vector<int>& arr);
+    
+    template<typename SortFunc>
+    double measureExecutionTime(SortFunc sortFunction, std::vector<int> arr, const std::string& name, double ops, double bytes) {
+        std::chrono::high_resolution_clock::time_point start, end;
+        {
+            perf::Region region(name + " " + std::to_string(arr.size()), ops, bytes);
+            start = std::chrono::high_resolution_clock::now();
+            sortFunction(arr);
+            end = std::chrono::high_resolution_clock::now();
+        }
+        
+        std::chrono::duration<double, std::milli> duration = end - start;
+        
+        if (!isSorted(arr)) {
+            std::cout << "Error: " << name << " failed to sort the array correctly!" << std::endl;
+        }
+        
+        return duration.count();
+    }
+    
+public:
+    // threads sizes the work-stealing pool (0 takes the OpenMP default), and
+    // pinThreads binds its workers one per allowed CPU.
+    SortingBenchmark(const std::vector<int>& arraySizes, int runs, int threads = 0, bool pinThreads = false);
+    
+    void sequentialBubbleSort(std::vector<int>& arr);
+    
+    void parallelBubbleSort(std::vector<int>& arr);
+    
+    // Odd-even transposition on the persistent pool: one parallel loop per
+    // phase, as with OpenMP, but a phase shorter than the grain runs on the
+    // calling thread and a longer one only wakes as many workers as it has
+    // pieces.
+    void workStealingBubbleSort(std::vector<int>& arr);
+    
+    void sequentialMerge(std::vector<int>& arr, std::vector<int>& temp, int left, int mid, int right);
+    
+    void sequentialMergeSortHelper(std::vector<int>& arr, std::vector<int>& temp, int left, int right);
+    
+    void sequentialMergeSort(std::vector<int>& arr);
+    
+    void parallelMergeSortHelper(std::vector<int>& arr, std::vector<int>& temp, int left, int right, int depth = 0);
+    
+    void parallelMergeSort(std::vector<int>& arr);
+    
+    // Recursion stops at the grain size instead of a fixed depth, and every
+    // merge runs in the task that owns both halves, so no critical section.
+    void workStealingMergeSortHelper(std::vector<int>& arr, std::vector<int>& temp, int left, int right);
+    
+    void workStealingMergeSort(std::vector<int>& arr);
+
+    // Cost of the scheduling itself: a parallel loop with one empty
+    // iteration per thread (fork and join only), and a batch of empty tasks
+    // spawned and synced (per-task cost), with OpenMP and with the pool.
+    void runOverheadBenchmark();
+    
+    void runBenchmark();
+};
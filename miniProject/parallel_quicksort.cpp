@@ -4,67 +4,495 @@
 #include <random>
 #include <chrono>
 #include <cmath>
+#include <string>
+#include <limits>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <sys/resource.h>
 #include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../common/perf_regions.h"
+#include "../hpc/sample_sort.h"
+
+// Reports how evenly the splitters divided the data: per-rank bucket sizes
+// (when asked) and the max/avg imbalance ratio. The slowest rank's final
+// local sort grows with its bucket, so this ratio bounds parallel efficiency.
+void report_bucket_balance(long long local_count, bool print_all, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    std::vector<long long> counts(size);
+    MPI_Gather(&local_count, 1, MPI_LONG_LONG, counts.data(), 1, MPI_LONG_LONG, 0, comm);
+    if (rank != 0) return;
+
+    long long total = 0, largest = 0, smallest = std::numeric_limits<long long>::max();
+    for (long long c : counts) {
+        total += c;
+        largest = std::max(largest, c);
+        smallest = std::min(smallest, c);
+    }
+    double average = static_cast<double>(total) / size;
+    if (print_all) {
+        std::cout << "Bucket sizes:";
+        for (int r = 0; r < size; ++r) {
+            std::cout << (r % 8 == 0 ? "\n  " : " ") << std::setw(10) << counts[r];
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "Bucket min/max:  " << smallest << " / " << largest << std::endl;
+    std::cout << "Imbalance:       " << std::fixed << std::setprecision(3)
+              << (average > 0 ? largest / average : 1.0) << " (max/avg)" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
 
-template<typename T>
-void swap(T& a, T& b) {
-    T temp = a;
-    a = b;
-    b = temp;
+// One line per run describing the ranks x threads layout and its memory
+// cost, so hybrid configurations at the same core count can be compared.
+// Peak RSS includes MPI's own buffers, which grow with the number of ranks.
+void report_hybrid_config(MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double peak_mb = usage.ru_maxrss / 1024.0; // ru_maxrss is in KiB on Linux
+    double max_mb = 0.0, total_mb = 0.0;
+    MPI_Reduce(&peak_mb, &max_mb, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+    MPI_Reduce(&peak_mb, &total_mb, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+    if (rank == 0) {
+        std::cout << "Ranks x Threads: " << size << " x " << threads << " (" << size * threads << " cores)" << std::endl;
+        std::cout << "Peak RSS:        " << max_mb << " MB max/rank, " << total_mb << " MB total" << std::endl;
+    }
 }
 
-template<typename T>
-int partition(std::vector<T>& arr, int low, int high) {
-    T pivot = arr[high];
-    int i = (low - 1);
-    for (int j = low; j <= high - 1; j++) {
-        if (arr[j] < pivot) {
-            i++;
-            swap(arr[i], arr[j]);
+// With -DPERF_REGIONS: every rank packs its regions, rank 0 merges them by
+// name (a region's time is the slowest rank's, its work the sum over
+// ranks, one counter row per rank labelled "rank r") and prints one roofline
+// table. All ranks measure the ceilings together, so the summed roofs are
+// those of the node(s) as the sort used them.
+void report_perf_regions(MPI_Comm comm) {
+    if (!perf::enabled) return;
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    std::vector<perf::RegionSummary> local = perf::collect();
+    std::vector<char> buf;
+    pack_pod(static_cast<int>(local.size()), buf);
+    for (const perf::RegionSummary& r : local) {
+        SortTraits<std::string>::pack(r.name, buf);
+        pack_pod(r.calls, buf);
+        pack_pod(r.seconds, buf);
+        pack_pod(r.ops, buf);
+        pack_pod(r.bytes, buf);
+        pack_pod(static_cast<int>(r.rows.size()), buf);
+        for (const perf::BreakdownRow& row : r.rows) pack_pod(row.counters, buf);
+    }
+    std::vector<char> all = gather_bytes(buf, 0, comm);
+
+    perf::Ceilings local_roof = perf::measureCeilings();
+    perf::Ceilings roof;
+    MPI_Reduce(&local_roof.gops, &roof.gops, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+    MPI_Reduce(&local_roof.gbs, &roof.gbs, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+    if (rank != 0) return;
+
+    std::vector<perf::RegionSummary> merged;
+    const char* p = all.data();
+    for (int source = 0; p < all.data() + all.size(); ++source) {
+        int regions = unpack_pod<int>(p);
+        for (int i = 0; i < regions; ++i) {
+            perf::RegionSummary r;
+            r.name = SortTraits<std::string>::unpack(p);
+            r.calls = unpack_pod<long>(p);
+            r.seconds = unpack_pod<double>(p);
+            r.ops = unpack_pod<double>(p);
+            r.bytes = unpack_pod<double>(p);
+            int rows = unpack_pod<int>(p);
+            for (int t = 0; t < rows; ++t) {
+                perf::BreakdownRow row;
+                row.label = "rank " + std::to_string(source);
+                row.counters = unpack_pod<perf::Counters>(p);
+                r.rows.push_back(row);
+            }
+
+            size_t j = 0;
+            while (j < merged.size() && merged[j].name != r.name) ++j;
+            if (j == merged.size()) {
+                merged.push_back(r);
+                continue;
+            }
+            merged[j].calls = std::max(merged[j].calls, r.calls);
+            merged[j].seconds = std::max(merged[j].seconds, r.seconds);
+            merged[j].ops += r.ops;
+            merged[j].bytes += r.bytes;
+            merged[j].rows.insert(merged[j].rows.end(), r.rows.begin(), r.rows.end());
         }
     }
-    swap(arr[i + 1], arr[high]);
-    return (i + 1);
+    perf::printReport(merged, roof);
 }
 
-template<typename T>
-void quicksort(std::vector<T>& arr, int low, int high) {
-    if (low < high) {
-        int pi = partition(arr, low, high);
-        quicksort(arr, low, pi - 1);
-        quicksort(arr, pi + 1, high);
+// Everything the command line can set.
+struct RunConfig {
+    long long N = 1000000;
+    bool distributed = false;
+    std::string input_path;
+    std::string output_path;
+    std::string gen_input_path;
+    std::string distribution = "uniform";
+    std::string type = "int"; // element type: int, record or string
+    int threads = 0; // OpenMP threads per rank, 0 = OMP_NUM_THREADS or 1
+    std::vector<long long> kth;    // selection mode: global ranks to find
+    std::vector<double> quantiles; // selection mode: quantiles to find
+    long long top_k = 0;           // selection mode: size of the top-k set
+    SortOptions sort;
+
+    bool selecting() const { return !kth.empty() || !quantiles.empty() || top_k > 0; }
+};
+
+// Comma-separated list of numbers, e.g. "0.5,0.9,0.99".
+template<typename V>
+std::vector<V> parse_list(const std::string& text) {
+    std::vector<V> values;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        if (comma > start) values.push_back(static_cast<V>(std::stod(text.substr(start, comma - start))));
+        start = comma + 1;
     }
+    return values;
 }
 
+// Loads or generates the distributed input the same way for every mode.
 template<typename T>
-bool is_sorted(const std::vector<T>& arr) {
-    for (size_t i = 0; i + 1 < arr.size(); ++i) {
-        if (arr[i] > arr[i + 1]) {
-            return false;
+std::vector<T> load_local_input(RunConfig& cfg, MPI_Comm comm) {
+    return cfg.input_path.empty() ? generate_local_block<T>(cfg.N, cfg.distribution, comm)
+                                  : read_input_file<T>(cfg.input_path, cfg.N, comm);
+}
+
+// Distributed mode: input is generated per rank or read with MPI-IO, the
+// sorted result stays distributed (optionally written with MPI-IO), and
+// nothing is funnelled through rank 0.
+template<typename T>
+int run_distributed(RunConfig& cfg) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    long long& N = cfg.N;
+    const std::string& input_path = cfg.input_path;
+    const std::string& output_path = cfg.output_path;
+
+    if (!SortTraits<T>::fixed_size && !(input_path.empty() && output_path.empty() && cfg.gen_input_path.empty())) {
+        if (rank == 0) {
+            std::cerr << "File input/output needs a fixed-size element type, not " << SortTraits<T>::name() << std::endl;
+        }
+        return 1;
+    }
+
+    if (!cfg.gen_input_path.empty()) {
+        std::vector<T> block = generate_local_block<T>(N, cfg.distribution, MPI_COMM_WORLD);
+        write_output_file(cfg.gen_input_path, block, MPI_COMM_WORLD);
+        if (rank == 0) {
+            std::cout << "Wrote " << N << " " << cfg.distribution << " " << SortTraits<T>::name() << "s to "
+                      << cfg.gen_input_path << std::endl;
+        }
+        return 0;
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_io = MPI_Wtime();
+    std::vector<T> local_data = load_local_input<T>(cfg, MPI_COMM_WORLD);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double read_time = MPI_Wtime() - start_io;
+    uint64_t input_checksum = distributed_checksum(local_data, MPI_COMM_WORLD);
+
+    long long local_bytes = 0;
+    for (size_t i = 0; i < local_data.size(); ++i) local_bytes += SortTraits<T>::bytes(local_data[i]);
+    long long total_bytes = 0;
+    MPI_Reduce(&local_bytes, &total_bytes, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        std::cout << "----------------------------------------" << std::endl;
+        std::cout << "MPI Quicksort (distributed mode)" << std::endl;
+        std::cout << "Array Size (N): " << N << std::endl;
+        std::cout << "Element Type:   " << SortTraits<T>::name() << " (" << total_bytes / 1e6 << " MB)" << std::endl;
+        std::cout << "MPI Processes Requested: " << size << std::endl;
+        std::cout << "----------------------------------------" << std::endl;
+        if (!input_path.empty()) {
+            std::cout << "Read Time:       " << read_time << " s" << std::endl;
         }
     }
-    return true;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_parallel = MPI_Wtime();
+    std::vector<T> local_sorted = parallel_sample_sort(local_data, cfg.sort, MPI_COMM_WORLD);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double parallel_time = MPI_Wtime() - start_parallel;
+
+    report_bucket_balance(local_sorted.size(), cfg.sort.report_buckets, MPI_COMM_WORLD);
+    report_hybrid_config(MPI_COMM_WORLD);
+    report_perf_regions(MPI_COMM_WORLD);
+
+    bool verified = verify_distributed_sorted(local_sorted, N, input_checksum, MPI_COMM_WORLD);
+
+    double write_time = 0.0;
+    if (!output_path.empty()) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        double start_write = MPI_Wtime();
+        write_output_file(output_path, local_sorted, MPI_COMM_WORLD);
+        MPI_Barrier(MPI_COMM_WORLD);
+        write_time = MPI_Wtime() - start_write;
+    }
+
+    if (rank == 0) {
+        std::cout << "Parallel Time:   " << parallel_time << " s" << std::endl;
+        if (parallel_time > 0) {
+            std::cout << "Throughput:      " << N / parallel_time / 1e6 << " Melem/s, "
+                      << total_bytes / parallel_time / 1e6 << " MB/s" << std::endl;
+        }
+        if (!output_path.empty()) {
+            std::cout << "Write Time:      " << write_time << " s" << std::endl;
+        }
+        if (verified) {
+            std::cout << "Parallel sort Verified (rank boundaries, checksum)." << std::endl;
+        } else {
+            std::cerr << "Parallel sort FAILED!" << std::endl;
+        }
+        std::cout << "----------------------------------------" << std::endl;
+    }
+    return verified ? 0 : 1;
 }
 
+// Selection mode: answers the requested ranks, quantiles and top-k with
+// distributed_select, then again by sorting everything and indexing, and
+// reports both times and whether the answers agree.
+template<typename T>
+int run_select(RunConfig& cfg) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (!SortTraits<T>::fixed_size && !cfg.input_path.empty()) {
+        if (rank == 0) {
+            std::cerr << "File input needs a fixed-size element type, not " << SortTraits<T>::name() << std::endl;
+        }
+        return 1;
+    }
+    std::vector<T> local_data = load_local_input<T>(cfg, MPI_COMM_WORLD);
+    const long long N = cfg.N;
+    if (N == 0) {
+        if (rank == 0) std::cerr << "Nothing to select from: N = 0" << std::endl;
+        return 1;
+    }
+
+    // Quantile q is the element of rank round(q * (N - 1)); top-k is
+    // checked through its threshold, the element of rank N - k.
+    std::vector<long long> ks;
+    std::vector<std::string> labels;
+    for (long long k : cfg.kth) {
+        ks.push_back(std::min(std::max(k, 0LL), N - 1));
+        labels.push_back("k = " + std::to_string(ks.back()));
+    }
+    for (double q : cfg.quantiles) {
+        double clamped = std::min(std::max(q, 0.0), 1.0);
+        ks.push_back(std::llround(clamped * (N - 1)));
+        std::ostringstream label;
+        label << "q = " << clamped;
+        labels.push_back(label.str());
+    }
+    long long top_k = std::min(cfg.top_k, N);
+
+    if (rank == 0) {
+        std::cout << "----------------------------------------" << std::endl;
+        std::cout << "MPI Distributed Selection" << std::endl;
+        std::cout << "Array Size (N): " << N << std::endl;
+        std::cout << "Element Type:   " << SortTraits<T>::name() << std::endl;
+        std::cout << "MPI Processes Requested: " << size << std::endl;
+        std::cout << "Targets:        " << ks.size() << (top_k > 0 ? " + top-k" : "") << std::endl;
+        std::cout << "----------------------------------------" << std::endl;
+    }
+
+    SelectStats stats;
+    std::vector<T> selected, top;
+    SelectStats top_stats;
+    double select_time = 0.0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    {
+        // Declared work is the first classification pass; later rounds only
+        // touch the shrinking candidate buckets.
+        perf::Region region("Distributed select", static_cast<double>(local_data.size()), data_bytes(local_data));
+        double start_select = MPI_Wtime();
+        selected = distributed_select(local_data, ks, cfg.sort, MPI_COMM_WORLD, &stats);
+        top = distributed_top_k(local_data, top_k, cfg.sort, MPI_COMM_WORLD, &top_stats);
+        MPI_Barrier(MPI_COMM_WORLD);
+        select_time = MPI_Wtime() - start_select;
+    }
+
+    long long rank_bytes = stats.bytes + top_stats.bytes, max_bytes = 0;
+    MPI_Reduce(&rank_bytes, &max_bytes, 1, MPI_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    // Baseline: full sample sort, then fetch the same ranks.
+    std::vector<long long> baseline_ks = ks;
+    if (top_k > 0) baseline_ks.push_back(N - top_k);
+    std::vector<T> copy(local_data);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_sort = MPI_Wtime();
+    std::vector<T> local_sorted = parallel_sample_sort(copy, cfg.sort, MPI_COMM_WORLD);
+    std::vector<T> indexed = index_sorted(local_sorted, baseline_ks, MPI_COMM_WORLD);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double sort_time = MPI_Wtime() - start_sort;
+
+    // top-k is right if exactly k elements were kept, none below the
+    // threshold.
+    long long top_local = top.size(), top_total = 0, below_local = 0, below_total = 0;
+    for (size_t i = 0; i < top.size(); ++i) {
+        if (top[i] < indexed.back()) ++below_local;
+    }
+    MPI_Reduce(&top_local, &top_total, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&below_local, &below_total, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    report_perf_regions(MPI_COMM_WORLD);
+
+    if (rank != 0) return 0;
+    bool ok = true;
+    for (size_t t = 0; t < ks.size(); ++t) {
+        bool match = !(selected[t] < indexed[t]) && !(indexed[t] < selected[t]);
+        ok = ok && match;
+        std::cout << std::left << std::setw(16) << labels[t] << std::right << SortTraits<T>::format(selected[t])
+                  << (match ? "" : "  MISMATCH, sort says " + SortTraits<T>::format(indexed[t])) << std::endl;
+    }
+    if (top_k > 0) {
+        bool match = top_total == top_k && below_total == 0;
+        ok = ok && match;
+        std::cout << std::left << std::setw(16) << ("top " + std::to_string(top_k)) << std::right << top_total
+                  << " kept, threshold " << SortTraits<T>::format(indexed.back()) << (match ? "" : "  MISMATCH")
+                  << std::endl;
+    }
+    std::cout << "----------------------------------------" << std::endl;
+    std::cout << "Select Time:     " << select_time << " s (" << stats.rounds << " rounds"
+              << (top_k > 0 ? " + " + std::to_string(top_stats.rounds) + " for top-k" : "") << ", "
+              << max_bytes / 1024.0 << " KiB max/rank)" << std::endl;
+    std::cout << "Sort+Index Time: " << sort_time << " s" << std::endl;
+    if (select_time > 1e-9) {
+        std::cout << "Speedup:         " << sort_time / select_time << "x" << std::endl;
+    }
+    if (ok) {
+        std::cout << "Selection Verified (matches sort-then-index)." << std::endl;
+    } else {
+        std::cerr << "Selection FAILED!" << std::endl;
+    }
+    std::cout << "----------------------------------------" << std::endl;
+    return ok ? 0 : 1;
+}
 
 int main(int argc, char *argv[]) {
-    MPI_Init(&argc, &argv);
+    // Hybrid mode: only the main thread makes MPI calls; OpenMP threads
+    // work between collectives (local sort, merge).
+    int thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
 
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    long long N = 1000000;
-    if (argc > 1) {
-        try {
-            N = std::stoll(argv[1]);
-        } catch (const std::exception& e) {
-            if (rank == 0) {
-                std::cerr << "Invalid array size argument. Using default N = " << N << std::endl;
+    RunConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--distributed") {
+            cfg.distributed = true;
+        } else if (arg == "--input" && has_value) {
+            cfg.input_path = argv[++i];
+            cfg.distributed = true;
+        } else if (arg == "--output" && has_value) {
+            cfg.output_path = argv[++i];
+            cfg.distributed = true;
+        } else if (arg == "--gen-input" && has_value) {
+            cfg.gen_input_path = argv[++i];
+            cfg.distributed = true;
+        } else if (arg == "--dist" && has_value) {
+            cfg.distribution = argv[++i];
+        } else if (arg == "--type" && has_value) {
+            cfg.type = argv[++i];
+        } else if (arg == "--kth" && has_value) {
+            cfg.kth = parse_list<long long>(argv[++i]);
+        } else if (arg == "--quantiles" && has_value) {
+            cfg.quantiles = parse_list<double>(argv[++i]);
+        } else if (arg == "--top" && has_value) {
+            cfg.top_k = std::max(0LL, std::atoll(argv[++i]));
+        } else if (arg == "--oversample" && has_value) {
+            cfg.sort.oversample = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--refine" && has_value) {
+            cfg.sort.refine_rounds = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--tolerance" && has_value) {
+            cfg.sort.tolerance = std::atof(argv[++i]);
+        } else if (arg == "--buckets") {
+            cfg.sort.report_buckets = true;
+        } else if (arg == "--chunk" && has_value) {
+            cfg.sort.chunk_elems = std::max(1LL, std::atoll(argv[++i]));
+        } else if (arg == "--pipeline" && has_value) {
+            cfg.sort.pipeline_depth = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && has_value) {
+            cfg.threads = std::max(1, std::atoi(argv[++i]));
+        } else {
+            try {
+                cfg.N = std::stoll(arg);
+            } catch (const std::exception& e) {
+                if (rank == 0) {
+                    std::cerr << "Invalid array size argument. Using default N = " << cfg.N << std::endl;
+                }
             }
         }
     }
 
+    if (thread_support < MPI_THREAD_FUNNELED && rank == 0) {
+        std::cerr << "WARNING: MPI library does not provide MPI_THREAD_FUNNELED." << std::endl;
+    }
+#ifdef _OPENMP
+    // Without an explicit thread count stay pure MPI (one thread per rank),
+    // as the default OpenMP team size would oversubscribe every core.
+    if (cfg.threads > 0) {
+        omp_set_num_threads(cfg.threads);
+    } else if (std::getenv("OMP_NUM_THREADS") == nullptr) {
+        omp_set_num_threads(1);
+    }
+#endif
+
+    // Records, strings and selection only run in distributed mode; the
+    // gather-to-rank-0 mode below is the int baseline against the
+    // sequential quicksort.
+    if (cfg.type != "int" || cfg.selecting()) cfg.distributed = true;
+
+    if (cfg.distributed) {
+        int status;
+        if (cfg.type == "int") {
+            status = cfg.selecting() ? run_select<int>(cfg) : run_distributed<int>(cfg);
+        } else if (cfg.type == "record") {
+            status = cfg.selecting() ? run_select<Record>(cfg) : run_distributed<Record>(cfg);
+        } else if (cfg.type == "string") {
+            status = cfg.selecting() ? run_select<std::string>(cfg) : run_distributed<std::string>(cfg);
+        } else {
+            if (rank == 0) std::cerr << "Unknown element type " << cfg.type << " (int, record, string)" << std::endl;
+            status = 1;
+        }
+        MPI_Finalize();
+        return status;
+    }
+
+    const long long N = cfg.N;
+
     if (rank == 0) {
         std::cout << "----------------------------------------" << std::endl;
         std::cout << "MPI Quicksort Performance Evaluation (Kaggle Node)" << std::endl;
@@ -81,20 +509,22 @@ int main(int argc, char *argv[]) {
         data.resize(N);
         std::random_device rd;
         std::mt19937 gen(rd());
-        std::uniform_int_distribution<> distrib(1, N * 10);
-        for (long long i = 0; i < N; ++i) {
-            data[i] = distrib(gen);
-        }
+        fill_random(data, N, cfg.distribution, gen);
 
         sequential_data = data;
 
-        auto start_seq = std::chrono::high_resolution_clock::now();
-        quicksort(sequential_data, 0, N - 1);
-        auto end_seq = std::chrono::high_resolution_clock::now();
+        std::chrono::high_resolution_clock::time_point start_seq, end_seq;
+        {
+            perf::Region region("Sequential quicksort", N * std::log2(std::max(2.0, static_cast<double>(N))),
+                                2.0 * N * sizeof(int));
+            start_seq = std::chrono::high_resolution_clock::now();
+            sequential::quicksort(sequential_data, 0, N - 1);
+            end_seq = std::chrono::high_resolution_clock::now();
+        }
         sequential_time = std::chrono::duration<double>(end_seq - start_seq).count();
         std::cout << "Sequential Time: " << sequential_time << " s" << std::endl;
 
-        if (!is_sorted(sequential_data)) {
+        if (!sequential::is_sorted(sequential_data)) {
              std::cerr << "Sequential sort FAILED!" << std::endl;
         }
     }
@@ -102,155 +532,61 @@ int main(int argc, char *argv[]) {
     MPI_Barrier(MPI_COMM_WORLD);
     double start_parallel = MPI_Wtime();
 
-    int local_n_base = N / size;
-    int remainder = N % size;
-    int local_n = (rank < remainder) ? local_n_base + 1 : local_n_base;
-
-    std::vector<int> sendcounts(size);
-    std::vector<int> displs(size);
-    int current_displ = 0;
-    for (int i = 0; i < size; ++i) {
-        sendcounts[i] = (i < remainder) ? local_n_base + 1 : local_n_base;
-        displs[i] = current_displ;
-        current_displ += sendcounts[i];
-    }
-
+    // Scatter and gather with 64-bit counts: rank 0 moves each block with
+    // send_large/recv_large, since MPI_Scatterv/Gatherv take int counts.
+    long long local_offset, local_n;
+    block_range(N, size, rank, local_offset, local_n);
     std::vector<int> local_data(local_n);
-    MPI_Scatterv(rank == 0 ? data.data() : nullptr, sendcounts.data(), displs.data(), MPI_INT,
-                 local_data.data(), local_n, MPI_INT, 0, MPI_COMM_WORLD);
-
-    std::sort(local_data.begin(), local_data.end());
-
-    int num_samples = size > 1 ? size : 1;
-    std::vector<int> samples;
-     samples.reserve(num_samples);
-    if (local_n > 0) {
-       for (int i = 0; i < num_samples; ++i) {
-          long long sample_index = static_cast<long long>(i) * local_n / num_samples;
-           if (sample_index >= local_n) sample_index = local_n -1;
-          samples.push_back(local_data[sample_index]);
-      }
-    } else {
-         samples.assign(num_samples, 0);
-    }
-    if (samples.size() < num_samples) {
-        samples.resize(num_samples, samples.empty() ? 0 : samples.back());
-    }
-
-
-    std::vector<int> gathered_samples;
     if (rank == 0) {
-        gathered_samples.resize(size * num_samples);
-    }
-    MPI_Gather(samples.data(), num_samples, MPI_INT,
-               gathered_samples.data(), num_samples, MPI_INT, 0, MPI_COMM_WORLD);
-
-    std::vector<int> pivots(size - 1);
-    if (size > 1 && rank == 0) {
-         std::sort(gathered_samples.begin(), gathered_samples.end());
-         for (int i = 0; i < size - 1; ++i) {
-             long long pivot_index = static_cast<long long>(i + 1) * num_samples - 1;
-              if (pivot_index < 0) pivot_index = 0;
-             if (pivot_index >= gathered_samples.size()) pivot_index = gathered_samples.size() -1;
-             pivots[i] = gathered_samples[pivot_index];
-         }
-        for (int i = 0; i < size - 2; ++i) {
-            if (pivots[i] >= pivots[i+1]) {
-                pivots[i+1] = pivots[i] + 1;
-            }
+        std::copy(data.begin(), data.begin() + local_n, local_data.begin());
+        for (int i = 1; i < size; ++i) {
+            long long offset, count;
+            block_range(N, size, i, offset, count);
+            send_large(data.data() + offset, count, i, 0, MPI_COMM_WORLD);
         }
-    }
-
-    if (size > 1) {
-        MPI_Bcast(pivots.data(), size - 1, MPI_INT, 0, MPI_COMM_WORLD);
-    }
-
-    std::vector<std::vector<int>> partitions(size);
-    std::vector<int> send_counts_alltoall(size, 0);
-    if (size > 1) {
-        for(int val : local_data) {
-             int dest_rank = 0;
-             while(dest_rank < size - 1 && val >= pivots[dest_rank]) {
-                 dest_rank++;
-             }
-             partitions[dest_rank].push_back(val);
-             send_counts_alltoall[dest_rank]++;
-         }
     } else {
-         partitions[0] = local_data;
-         send_counts_alltoall[0] = local_data.size();
+        recv_large(local_data.data(), local_n, 0, 0, MPI_COMM_WORLD);
     }
 
+    std::vector<int> recv_buffer_alltoall = parallel_sample_sort(local_data, cfg.sort, MPI_COMM_WORLD);
 
-    std::vector<int> recv_counts_alltoall(size);
-    MPI_Alltoall(send_counts_alltoall.data(), 1, MPI_INT,
-                 recv_counts_alltoall.data(), 1, MPI_INT, MPI_COMM_WORLD);
-
-    std::vector<int> send_displs_alltoall(size, 0);
-    std::vector<int> recv_displs_alltoall(size, 0);
-    int total_send_size = 0;
-    int total_recv_size = 0;
-    for (int i = 0; i < size; ++i) {
-        send_displs_alltoall[i] = total_send_size;
-        recv_displs_alltoall[i] = total_recv_size;
-        total_send_size += send_counts_alltoall[i];
-        total_recv_size += recv_counts_alltoall[i];
-    }
-
-    std::vector<int> send_buffer_alltoall(total_send_size);
-    if (size > 1) {
-       int current_pos = 0;
-       for(int i=0; i<size; ++i) {
-            if (send_counts_alltoall[i] > 0) {
-                std::copy(partitions[i].begin(), partitions[i].end(), send_buffer_alltoall.begin() + current_pos);
-                current_pos += send_counts_alltoall[i];
-            }
-       }
-    } else {
-        send_buffer_alltoall = partitions[0];
-    }
-
-    std::vector<int> recv_buffer_alltoall(total_recv_size);
-    MPI_Alltoallv(send_buffer_alltoall.data(), send_counts_alltoall.data(), send_displs_alltoall.data(), MPI_INT,
-                  recv_buffer_alltoall.data(), recv_counts_alltoall.data(), recv_displs_alltoall.data(), MPI_INT, MPI_COMM_WORLD);
-
-    std::sort(recv_buffer_alltoall.begin(), recv_buffer_alltoall.end());
-
-    std::vector<int> final_recv_counts(size);
-    std::vector<int> final_displs(size);
-
-    int final_local_size = recv_buffer_alltoall.size();
-    MPI_Gather(&final_local_size, 1, MPI_INT, final_recv_counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    std::vector<long long> final_recv_counts(size);
+    long long final_local_size = recv_buffer_alltoall.size();
+    MPI_Gather(&final_local_size, 1, MPI_LONG_LONG, final_recv_counts.data(), 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
 
     std::vector<int> final_data;
     if (rank == 0) {
-        final_displs[0] = 0;
-        long long total_final_size = final_recv_counts[0];
-        for (int i = 1; i < size; ++i) {
-            final_displs[i] = final_displs[i - 1] + final_recv_counts[i - 1];
+        long long total_final_size = 0;
+        for (int i = 0; i < size; ++i) {
             total_final_size += final_recv_counts[i];
         }
          if (total_final_size != N) {
             std::cerr << "WARNING: Final calculated size mismatch! " << total_final_size << " != " << N << ". Resizing result vector." << std::endl;
-            final_data.resize(total_final_size);
-         } else {
-             final_data.resize(N);
          }
+        final_data.resize(total_final_size);
+        std::copy(recv_buffer_alltoall.begin(), recv_buffer_alltoall.end(), final_data.begin());
+        long long displ = final_recv_counts[0];
+        for (int i = 1; i < size; ++i) {
+            recv_large(final_data.data() + displ, final_recv_counts[i], i, 1, MPI_COMM_WORLD);
+            displ += final_recv_counts[i];
+        }
+    } else {
+        send_large(recv_buffer_alltoall.data(), final_local_size, 0, 1, MPI_COMM_WORLD);
     }
 
-    MPI_Gatherv(recv_buffer_alltoall.data(), final_local_size, MPI_INT,
-                final_data.data(), final_recv_counts.data(), final_displs.data(), MPI_INT,
-                0, MPI_COMM_WORLD);
-
 
     MPI_Barrier(MPI_COMM_WORLD);
     double end_parallel = MPI_Wtime();
     double parallel_time = end_parallel - start_parallel;
 
+    report_bucket_balance(recv_buffer_alltoall.size(), cfg.sort.report_buckets, MPI_COMM_WORLD);
+    report_hybrid_config(MPI_COMM_WORLD);
+    report_perf_regions(MPI_COMM_WORLD);
+
     if (rank == 0) {
         std::cout << "Parallel Time:   " << parallel_time << " s" << std::endl;
 
-         if (!is_sorted(final_data)) {
+         if (!sequential::is_sorted(final_data)) {
              std::cerr << "Parallel sort FAILED!" << std::endl;
          } else {
              std::cout << "Parallel sort Verified." << std::endl;
@@ -273,27 +609,19 @@ int main(int argc, char *argv[]) {
 /*
 Commands
 
-!mpic++ parallel_quicksort.cpp -o parallel_quicksort -std=c++11 -O3
+!mpic++ parallel_quicksort.cpp -o parallel_quicksort -std=c++11 -O3 -fopenmp
+With counters: add -DPERF_REGIONS
 
 mpirun -np 8 --oversubscribe --allow-run-as-root ./parallel_quicksort 2000000
 
-*/
+mpirun -np 8 --oversubscribe --allow-run-as-root ./parallel_quicksort 2000000 --gen-input input.bin
+mpirun -np 8 --oversubscribe --allow-run-as-root ./parallel_quicksort --input input.bin --output sorted.bin
 
-/*
--------------------------------------------
-Output
--------------------------------------------
-
-----------------------------------------
-MPI Quicksort Performance Evaluation (Kaggle Node)
-Array Size (N): 2000000
-MPI Processes Requested: 8
-----------------------------------------
-Sequential Time: 0.53989 s
-Parallel Time:   0.238298 s
-Parallel sort Verified.
-----------------------------------------
-Speedup:         2.26561x
-----------------------------------------
-
-*/
\ No newline at end of file
+mpirun -np 8 --oversubscribe --allow-run-as-root ./parallel_quicksort 2000000 --dist dups --oversample 8 --refine 5 --buckets
+
+mpirun -np 8 --oversubscribe --allow-run-as-root ./parallel_quicksort 2000000 --type record
+mpirun -np 8 --oversubscribe --allow-run-as-root ./parallel_quicksort 2000000 --type string --dist skewed
+
+mpirun -np 8 --oversubscribe --allow-run-as-root ./parallel_quicksort 20000000 --quantiles 0.5,0.9,0.99 --kth 0 --top 100
+
+*/
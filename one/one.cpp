@@ -1,157 +1,14 @@
 #include <iostream>
 #include <vector>
-#include <queue>
-#include <stack>
-#include <unordered_set>
 #include <omp.h>
 #include <chrono>
+#include "../common/perf_regions.h"
+#include "../common/work_stealing.h"
+#include "../hpc/dynamic_graph.h"
+#include "../hpc/graph.h"
 using namespace std;
 #define int long long
 
-class Graph {
-private:
-    int vertices;
-    vector<vector<int>> adjacencyList;
-
-public:
-    Graph(int v) : vertices(v) {
-        adjacencyList.resize(v);
-    }
-
-    void addEdge(int v, int w) {
-        adjacencyList[v].push_back(w);
-        adjacencyList[w].push_back(v);
-    }
-
-    void sequentialBFS(int startVertex) {
-        vector<bool> visited(vertices, false);
-        queue<int> queue;
-
-        visited[startVertex] = true;
-        queue.push(startVertex);
-
-        while (!queue.empty()) {
-            int currentVertex = queue.front();
-            queue.pop();
-            
-            for (int adjacentVertex : adjacencyList[currentVertex]) {
-                if (!visited[adjacentVertex]) {
-                    visited[adjacentVertex] = true;
-                    queue.push(adjacentVertex);
-                }
-            }
-        }
-    }
-
-    void parallelBFS(int startVertex) {
-        vector<bool> visited(vertices, false);
-        vector<int> frontier;
-        vector<int> next_frontier;
-
-        visited[startVertex] = true;
-        frontier.push_back(startVertex);
-
-        while (!frontier.empty()) {
-            next_frontier.clear();
-
-            #pragma omp parallel
-            {
-                vector<int> local_frontier;
-
-                #pragma omp for nowait
-                for (size_t i = 0; i < frontier.size(); i++) {
-                    int currentVertex = frontier[i];
-                    
-                    for (int adjacentVertex : adjacencyList[currentVertex]) {
-                        bool was_visited = false;
-                        
-                        #pragma omp critical
-                        {
-                            if (!visited[adjacentVertex]) {
-                                visited[adjacentVertex] = true;
-                                local_frontier.push_back(adjacentVertex);
-                            }
-                        }
-                    }
-                }
-
-                #pragma omp critical
-                {
-                    next_frontier.insert(next_frontier.end(), local_frontier.begin(), local_frontier.end());
-                }
-            }
-
-            frontier.swap(next_frontier);
-        }
-    }
-
-    void sequentialDFS(int startVertex) {
-        vector<bool> visited(vertices, false);
-        stack<int> stack;
-
-        stack.push(startVertex);
-
-        while (!stack.empty()) {
-            int currentVertex = stack.top();
-            stack.pop();
-
-            if (!visited[currentVertex]) {
-                visited[currentVertex] = true;
-                
-                for (int adjacentVertex : adjacencyList[currentVertex]) {
-                    if (!visited[adjacentVertex]) {
-                        stack.push(adjacentVertex);
-                    }
-                }
-            }
-        }
-    }
-
-    void parallelDFS(int startVertex) {
-        vector<bool> visited(vertices, false);
-        stack<int> stack;
-        
-        visited[startVertex] = true;
-        stack.push(startVertex);
-        
-        while (!stack.empty()) {
-            vector<int> current_level;
-            
-            while (!stack.empty()) {
-                current_level.push_back(stack.top());
-                stack.pop();
-            }
-            
-            #pragma omp parallel
-            {
-                vector<int> local_stack;
-                
-                #pragma omp for nowait
-                for (size_t i = 0; i < current_level.size(); i++) {
-                    int currentVertex = current_level[i];
-                    
-                    for (int adjacentVertex : adjacencyList[currentVertex]) {
-                        #pragma omp critical
-                        {
-                            if (!visited[adjacentVertex]) {
-                                visited[adjacentVertex] = true;
-                                local_stack.push_back(adjacentVertex);
-                            }
-                        }
-                    }
-                }
-                
-                #pragma omp critical
-                {
-                    for (int vertex : local_stack) {
-                        stack.push(vertex);
-                    }
-                }
-            }
-        }
-    }
-};
-
 int32_t main() {
     int numVertices = 2e7;
     int numEdges = 2e7;
@@ -165,35 +22,113 @@ int32_t main() {
         g.addEdge(v, w);
     }
     
-    auto start_time = chrono::high_resolution_clock::now();
-    g.sequentialBFS(startVertex);
-    auto end_time = chrono::high_resolution_clock::now();
+    double ops = g.traversalOps();
+    double bytes = g.traversalBytes();
+
+    chrono::high_resolution_clock::time_point start_time, end_time;
+    {
+        perf::Region region("Sequential BFS", ops, bytes);
+        start_time = chrono::high_resolution_clock::now();
+        g.sequentialBFS(startVertex);
+        end_time = chrono::high_resolution_clock::now();
+    }
     auto duration = chrono::duration_cast<chrono::milliseconds>(end_time - start_time);
     cout << "Sequential BFS execution time: " << duration.count() << " ms\n";
     
-    start_time = chrono::high_resolution_clock::now();
-    g.parallelBFS(startVertex);
-    end_time = chrono::high_resolution_clock::now();
+    {
+        perf::Region region("Parallel BFS", ops, bytes);
+        start_time = chrono::high_resolution_clock::now();
+        g.parallelBFS(startVertex);
+        end_time = chrono::high_resolution_clock::now();
+    }
     duration = chrono::duration_cast<chrono::milliseconds>(end_time - start_time);
     cout << "Parallel BFS execution time: " << duration.count() << " ms\n";
     
-    start_time = chrono::high_resolution_clock::now();
-    g.sequentialDFS(startVertex);
-    end_time = chrono::high_resolution_clock::now();
+    {
+        perf::Region region("Sequential DFS", ops, bytes);
+        start_time = chrono::high_resolution_clock::now();
+        g.sequentialDFS(startVertex);
+        end_time = chrono::high_resolution_clock::now();
+    }
     duration = chrono::duration_cast<chrono::milliseconds>(end_time - start_time);
     cout << "Sequential DFS execution time: " << duration.count() << " ms\n";
     
-    start_time = chrono::high_resolution_clock::now();
-    g.parallelDFS(startVertex);
-    end_time = chrono::high_resolution_clock::now();
+    {
+        perf::Region region("Parallel DFS", ops, bytes);
+        start_time = chrono::high_resolution_clock::now();
+        g.parallelDFS(startVertex);
+        end_time = chrono::high_resolution_clock::now();
+    }
     duration = chrono::duration_cast<chrono::milliseconds>(end_time - start_time);
     cout << "Parallel DFS execution time: " << duration.count() << " ms\n";
+
+    ws::Scheduler pool(omp_get_max_threads());
+
+    {
+        perf::Region region("Work-stealing BFS", ops, bytes);
+        start_time = chrono::high_resolution_clock::now();
+        g.workStealingBFS(pool, startVertex);
+        end_time = chrono::high_resolution_clock::now();
+    }
+    duration = chrono::duration_cast<chrono::milliseconds>(end_time - start_time);
+    cout << "Work-stealing BFS execution time: " << duration.count() << " ms\n";
+
+    {
+        perf::Region region("Work-stealing DFS", ops, bytes);
+        start_time = chrono::high_resolution_clock::now();
+        g.workStealingDFS(pool, startVertex);
+        end_time = chrono::high_resolution_clock::now();
+    }
+    duration = chrono::duration_cast<chrono::milliseconds>(end_time - start_time);
+    cout << "Work-stealing DFS execution time: " << duration.count() << " ms\n";
+
+    // Streaming updates: a graph that changes in batches of insertions and
+    // deletions, with BFS distances from the start vertex repaired per batch
+    // instead of recomputed from scratch.
+    int streamVertices = 2e6;
+    int batchSize = 1000;
+    int numBatches = 10;
+    DynamicGraph stream(streamVertices, vector<int>(1, startVertex));
+    vector<DynamicGraph::Edge> streamEdges(2 * streamVertices);
+    for (DynamicGraph::Edge& e : streamEdges) e = {rand() % streamVertices, rand() % streamVertices};
+    stream.applyBatch(pool, streamEdges, vector<DynamicGraph::Edge>());
+
+    double repairMs = 0, recomputeMs = 0;
+    for (int b = 0; b < numBatches; b++) {
+        vector<DynamicGraph::Edge> insertions, deletions;
+        for (int i = 0; i < batchSize; i++) {
+            insertions.push_back({rand() % streamVertices, rand() % streamVertices});
+            int victim = rand() % streamEdges.size();
+            deletions.push_back(streamEdges[victim]);
+            streamEdges[victim] = streamEdges.back();
+            streamEdges.pop_back();
+        }
+        streamEdges.insert(streamEdges.end(), insertions.begin(), insertions.end());
+
+        start_time = chrono::high_resolution_clock::now();
+        stream.applyBatch(pool, insertions, deletions);
+        end_time = chrono::high_resolution_clock::now();
+        repairMs += chrono::duration<double, milli>(end_time - start_time).count();
+
+        start_time = chrono::high_resolution_clock::now();
+        stream.recompute(pool);
+        end_time = chrono::high_resolution_clock::now();
+        recomputeMs += chrono::duration<double, milli>(end_time - start_time).count();
+    }
+    cout << "Incremental BFS per batch (" << batchSize << " inserts + " << batchSize << " deletes): "
+         << repairMs / numBatches << " ms\n";
+    cout << "Recomputed BFS per batch: " << recomputeMs / numBatches << " ms\n";
+    cout << "Streaming distances verified: " << (stream.verify() ? "yes" : "no") << "\n";
+
+    perf::report();
     
     return 0;
 }
 
 /* 
-Command -> g++ -fopenmp one.cpp -o parallel_bfs_dfs && ./parallel_bfs_dfs 
+Command -> g++ -fopenmp one.cpp ../hpc/graph.cpp ../hpc/dynamic_graph.cpp -o parallel_bfs_dfs && ./parallel_bfs_dfs 
+Counters -> g++ -O2 -fopenmp -DPERF_REGIONS one.cpp ../hpc/graph.cpp ../hpc/dynamic_graph.cpp -o parallel_bfs_dfs && ./parallel_bfs_dfs
+CMake -> cmake -S .. -B ../build && cmake --build ../build --target parallel_bfs_dfs
 
 -----------------------
 Output
@@ -0,0 +1,433 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <limits>
+#include <iomanip>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <omp.h>
+#include <mpi.h>
+
+using namespace std;
+
+// Fused statistics record: one pass over the data yields min, max, sum,
+// sum of squares and count, so Average and Std Dev come for free.
+struct Stats {
+    long long count;
+    long long sum;
+    double sumSquares;
+    int minVal;
+    int maxVal;
+};
+
+// A reduction operation is a policy with an identity, a way to fold one
+// element into a partial, and an associative/commutative combine of partials.
+struct MinOp {
+    typedef int Value;
+    static Value identity() { return numeric_limits<int>::max(); }
+    static void accumulate(Value& acc, int x) { if (x < acc) acc = x; }
+    static void combine(Value& acc, const Value& other) { if (other < acc) acc = other; }
+};
+
+struct MaxOp {
+    typedef int Value;
+    static Value identity() { return numeric_limits<int>::min(); }
+    static void accumulate(Value& acc, int x) { if (x > acc) acc = x; }
+    static void combine(Value& acc, const Value& other) { if (other > acc) acc = other; }
+};
+
+struct SumOp {
+    typedef long long Value;
+    static Value identity() { return 0; }
+    static void accumulate(Value& acc, int x) { acc += x; }
+    static void combine(Value& acc, const Value& other) { acc += other; }
+};
+
+struct StatsOp {
+    typedef Stats Value;
+    static Value identity() {
+        Stats s;
+        s.count = 0;
+        s.sum = 0;
+        s.sumSquares = 0.0;
+        s.minVal = numeric_limits<int>::max();
+        s.maxVal = numeric_limits<int>::min();
+        return s;
+    }
+    static void accumulate(Value& acc, int x) {
+        acc.count++;
+        acc.sum += x;
+        acc.sumSquares += static_cast<double>(x) * x;
+        if (x < acc.minVal) acc.minVal = x;
+        if (x > acc.maxVal) acc.maxVal = x;
+    }
+    static void combine(Value& acc, const Value& other) {
+        acc.count += other.count;
+        acc.sum += other.sum;
+        acc.sumSquares += other.sumSquares;
+        if (other.minVal < acc.minVal) acc.minVal = other.minVal;
+        if (other.maxVal > acc.maxVal) acc.maxVal = other.maxVal;
+    }
+};
+
+ostream& operator<<(ostream& os, const Stats& s) {
+    double mean = s.count > 0 ? static_cast<double>(s.sum) / s.count : 0.0;
+    double variance = s.count > 0 ? s.sumSquares / s.count - mean * mean : 0.0;
+    os << "{min " << s.minVal << ", max " << s.maxVal << ", sum " << s.sum
+       << ", count " << s.count << ", avg " << fixed << setprecision(3) << mean
+       << ", stddev " << (variance > 0 ? sqrt(variance) : 0.0) << "}";
+    return os;
+}
+
+bool sameValue(int a, int b) { return a == b; }
+bool sameValue(long long a, long long b) { return a == b; }
+bool sameValue(const Stats& a, const Stats& b) {
+    // sumSquares is a double combined in a different order on each path.
+    double tolerance = 1e-9 * (a.sumSquares > 1.0 ? a.sumSquares : 1.0);
+    return a.count == b.count && a.sum == b.sum && a.minVal == b.minVal && a.maxVal == b.maxVal &&
+           (a.sumSquares - b.sumSquares < tolerance) && (b.sumSquares - a.sumSquares < tolerance);
+}
+
+class ReductionOpBase {
+public:
+    virtual ~ReductionOpBase() {}
+};
+
+// Wraps Op::combine as an MPI user-defined operation. Values travel as an
+// opaque contiguous byte type, which is fine on homogeneous clusters.
+template<typename Op>
+class MPIReductionOp : public ReductionOpBase {
+public:
+    typedef typename Op::Value Value;
+
+    MPIReductionOp() {
+        MPI_Type_contiguous(sizeof(Value), MPI_BYTE, &type);
+        MPI_Type_commit(&type);
+        MPI_Op_create(&MPIReductionOp::apply, 1, &op);
+    }
+
+    ~MPIReductionOp() {
+        MPI_Op_free(&op);
+        MPI_Type_free(&type);
+    }
+
+    MPI_Datatype type;
+    MPI_Op op;
+
+private:
+    MPIReductionOp(const MPIReductionOp&);
+    MPIReductionOp& operator=(const MPIReductionOp&);
+
+    static void apply(void* in, void* inout, int* len, MPI_Datatype*) {
+        Value* a = static_cast<Value*>(in);
+        Value* b = static_cast<Value*>(inout);
+        for (int i = 0; i < *len; i++) {
+            Op::combine(b[i], a[i]);
+        }
+    }
+};
+
+// Three-level allreduce:
+//   1. OpenMP threads reduce the rank's local data into one partial.
+//   2. Ranks sharing a node publish partials into an MPI-3 shared-memory
+//      window; the node leader combines them in place, no messages needed.
+//   3. Node leaders run MPI_Allreduce among themselves and publish the
+//      global result back through the window.
+// ranksPerNode > 0 splits each physical node into smaller groups so the
+// inter-node level can be exercised with mpirun on a single machine.
+class HierarchicalReducer {
+private:
+    MPI_Comm worldComm;
+    MPI_Comm nodeComm;
+    MPI_Comm leaderComm;
+    int nodeRank;
+    int nodeSize;
+    int numNodes;
+
+    // Persistent node-local window: one cache line per rank for its partial
+    // plus one extra line on the leader for the published result.
+    static const int SLOT_BYTES = 64;
+    MPI_Win window;
+    vector<char*> slotPtrs;
+    char* resultPtr;
+
+    // One MPI type and op per reduction, kept for the reducer's lifetime so
+    // the timed calls never create or free them.
+    vector<ReductionOpBase*> mpiOps;
+
+public:
+    HierarchicalReducer(MPI_Comm comm, int ranksPerNode) : worldComm(comm), leaderComm(MPI_COMM_NULL) {
+        int worldRank;
+        MPI_Comm_rank(worldComm, &worldRank);
+
+        MPI_Comm sharedComm;
+        MPI_Comm_split_type(worldComm, MPI_COMM_TYPE_SHARED, worldRank, MPI_INFO_NULL, &sharedComm);
+        if (ranksPerNode > 0) {
+            int sharedRank;
+            MPI_Comm_rank(sharedComm, &sharedRank);
+            MPI_Comm_split(sharedComm, sharedRank / ranksPerNode, sharedRank, &nodeComm);
+            MPI_Comm_free(&sharedComm);
+        } else {
+            nodeComm = sharedComm;
+        }
+        MPI_Comm_rank(nodeComm, &nodeRank);
+        MPI_Comm_size(nodeComm, &nodeSize);
+
+        MPI_Comm_split(worldComm, nodeRank == 0 ? 0 : MPI_UNDEFINED, worldRank, &leaderComm);
+        if (nodeRank == 0) {
+            MPI_Comm_size(leaderComm, &numNodes);
+        }
+        MPI_Bcast(&numNodes, 1, MPI_INT, 0, nodeComm);
+
+        char* base;
+        MPI_Aint bytes = nodeRank == 0 ? 2 * SLOT_BYTES : SLOT_BYTES;
+        MPI_Win_allocate_shared(bytes, 1, MPI_INFO_NULL, nodeComm, &base, &window);
+        slotPtrs.resize(nodeSize);
+        for (int r = 0; r < nodeSize; r++) {
+            MPI_Aint segmentSize;
+            int dispUnit;
+            MPI_Win_shared_query(window, r, &segmentSize, &dispUnit, &slotPtrs[r]);
+        }
+        resultPtr = slotPtrs[0] + SLOT_BYTES;
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+    }
+
+    ~HierarchicalReducer() {
+        for (size_t i = 0; i < mpiOps.size(); i++) {
+            delete mpiOps[i];
+        }
+        MPI_Win_unlock_all(window);
+        MPI_Win_free(&window);
+        if (leaderComm != MPI_COMM_NULL) {
+            MPI_Comm_free(&leaderComm);
+        }
+        MPI_Comm_free(&nodeComm);
+    }
+
+    int getNodeCount() const { return numNodes; }
+    int getNodeSize() const { return nodeSize; }
+
+    // Created on first use; call it once before timing to keep the creation
+    // off the clock.
+    template<typename Op>
+    MPIReductionOp<Op>& reductionOp() {
+        for (size_t i = 0; i < mpiOps.size(); i++) {
+            if (MPIReductionOp<Op>* found = dynamic_cast<MPIReductionOp<Op>*>(mpiOps[i])) {
+                return *found;
+            }
+        }
+        MPIReductionOp<Op>* created = new MPIReductionOp<Op>();
+        mpiOps.push_back(created);
+        return *created;
+    }
+
+    template<typename Op>
+    static typename Op::Value localReduce(const vector<int>& data) {
+        typedef typename Op::Value Value;
+        int numThreads = omp_get_max_threads();
+        vector<Value> partials(numThreads, Op::identity());
+        long long n = data.size();
+
+        #pragma omp parallel
+        {
+            Value acc = Op::identity();
+            #pragma omp for nowait
+            for (long long i = 0; i < n; i++) {
+                Op::accumulate(acc, data[i]);
+            }
+            partials[omp_get_thread_num()] = acc;
+        }
+
+        Value result = Op::identity();
+        for (int t = 0; t < numThreads; t++) {
+            Op::combine(result, partials[t]);
+        }
+        return result;
+    }
+
+    template<typename Op>
+    typename Op::Value allreduce(const vector<int>& data) {
+        typedef typename Op::Value Value;
+        static_assert(sizeof(Value) <= SLOT_BYTES, "reduction value does not fit a window slot");
+        Value local = localReduce<Op>(data);
+
+        // Publish: everyone writes its partial, then the barrier (bracketed
+        // by Win_sync) makes all partials visible to the leader.
+        memcpy(slotPtrs[nodeRank], &local, sizeof(Value));
+        MPI_Win_sync(window);
+        MPI_Barrier(nodeComm);
+        MPI_Win_sync(window);
+
+        if (nodeRank == 0) {
+            Value nodeResult = Op::identity();
+            for (int r = 0; r < nodeSize; r++) {
+                Value partial;
+                memcpy(&partial, slotPtrs[r], sizeof(Value));
+                Op::combine(nodeResult, partial);
+            }
+            if (numNodes > 1) {
+                MPIReductionOp<Op>& mpiOp = reductionOp<Op>();
+                Value globalResult;
+                MPI_Allreduce(&nodeResult, &globalResult, 1, mpiOp.type, mpiOp.op, leaderComm);
+                nodeResult = globalResult;
+            }
+            memcpy(resultPtr, &nodeResult, sizeof(Value));
+            MPI_Win_sync(window);
+        }
+
+        // The result lives in its own slot, so the next call's partials can
+        // be written while slower ranks are still reading this result.
+        MPI_Barrier(nodeComm);
+        MPI_Win_sync(window);
+        Value result;
+        memcpy(&result, resultPtr, sizeof(Value));
+        return result;
+    }
+
+    // Baseline for comparison: every rank joins one flat MPI_Allreduce.
+    template<typename Op>
+    typename Op::Value flatAllreduce(const vector<int>& data) {
+        typedef typename Op::Value Value;
+        Value local = localReduce<Op>(data);
+        MPIReductionOp<Op>& mpiOp = reductionOp<Op>();
+        Value result;
+        MPI_Allreduce(&local, &result, 1, mpiOp.type, mpiOp.op, worldComm);
+        return result;
+    }
+};
+
+class DistributedReduction {
+private:
+    vector<int> data;
+    long long size;
+    int rank;
+    int numRanks;
+    int numRuns;
+    HierarchicalReducer reducer;
+
+    vector<int> generateRandomData(long long size, int min, int max) {
+        vector<int> result(size);
+        mt19937 gen(12345 + rank);
+        uniform_int_distribution<> distrib(min, max);
+
+        for (long long i = 0; i < size; i++) {
+            result[i] = distrib(gen);
+        }
+
+        return result;
+    }
+
+    template<typename Operation>
+    double measureExecutionTime(Operation op, const string& name) {
+        typedef decltype(op()) Value;
+        Value result = Value();
+        double best = numeric_limits<double>::max();
+        for (int run = 0; run < numRuns; run++) {
+            MPI_Barrier(MPI_COMM_WORLD);
+            double start = MPI_Wtime();
+            result = op();
+            double elapsed = MPI_Wtime() - start;
+            double slowest;
+            MPI_Allreduce(&elapsed, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+            if (slowest < best) best = slowest;
+        }
+
+        if (rank == 0) {
+            cout << name << " result: " << result << ", Time: " << fixed << setprecision(3) << best * 1000.0 << " ms" << endl;
+        }
+        return best * 1000.0;
+    }
+
+    template<typename Op>
+    void compare(const string& name) {
+        typename Op::Value flat = Op::identity();
+        typename Op::Value hier = Op::identity();
+        reducer.reductionOp<Op>();
+        double flatTime = measureExecutionTime([&]() { return flat = reducer.flatAllreduce<Op>(data); }, "Flat " + name);
+        double hierTime = measureExecutionTime([&]() { return hier = reducer.allreduce<Op>(data); }, "Hierarchical " + name);
+
+        int ok = sameValue(flat, hier) ? 1 : 0;
+        int allOk;
+        MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (rank == 0) {
+            cout << "  " << name << (allOk ? " verified" : " MISMATCH") << ", flat/hierarchical: "
+                 << fixed << setprecision(2) << flatTime / hierTime << "x" << endl;
+        }
+    }
+
+public:
+    DistributedReduction(long long dataSizePerRank, int minVal, int maxVal, int ranksPerNode, int runs)
+        : size(dataSizePerRank), numRuns(runs), reducer(MPI_COMM_WORLD, ranksPerNode) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+        data = generateRandomData(size, minVal, maxVal);
+    }
+
+    void runBenchmark() {
+        if (rank == 0) {
+            cout << "Elements per rank: " << size << ", Ranks: " << numRanks
+                 << ", Nodes: " << reducer.getNodeCount()
+                 << ", Threads per rank: " << omp_get_max_threads() << endl;
+            cout << "------------------------------------------------------------" << endl;
+        }
+
+        compare<MinOp>("Min");
+        compare<MaxOp>("Max");
+        compare<SumOp>("Sum");
+        compare<StatsOp>("Stats");
+
+        if (rank == 0) {
+            cout << "------------------------------------------------------------" << endl;
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    MPI_Init(&argc, &argv);
+
+    long long dataSize = 1e7; // elements per rank
+    int ranksPerNode = 0;     // 0 = use the real node boundaries
+    int numRuns = 5;
+    if (argc > 1) dataSize = stoll(argv[1]);
+    if (argc > 2) ranksPerNode = stoi(argv[2]);
+    if (argc > 3) numRuns = stoi(argv[3]);
+
+    {
+        DistributedReduction reduction(dataSize, -10000, 10000, ranksPerNode, numRuns);
+        reduction.runBenchmark();
+    }
+
+    MPI_Finalize();
+    return 0;
+}
+
+/*
+Command -> mpic++ -fopenmp -O3 three_mpi.cpp -o three_mpi
+           mpirun -np 8 --oversubscribe --allow-run-as-root ./three_mpi <elements_per_rank> [ranks_per_node] [runs]
+
+ranks_per_node emulates several nodes on one machine, e.g. 8 ranks with
+ranks_per_node = 2 gives 4 "nodes" whose leaders do the inter-node allreduce.
+*/
+
+/*
+---------------------------
+Output (mpirun -np 4 ./three_mpi 1000000 2 3, OMP_NUM_THREADS=2)
+----------------------------
+Elements per rank: 1000000, Ranks: 4, Nodes: 2, Threads per rank: 2
+------------------------------------------------------------
+Flat Min result: -10000, Time: 2.202 ms
+Hierarchical Min result: -10000, Time: 1.602 ms
+  Min verified, flat/hierarchical: 1.37x
+Flat Max result: 10000, Time: 1.538 ms
+Hierarchical Max result: 10000, Time: 1.555 ms
+  Max verified, flat/hierarchical: 0.99x
+Flat Sum result: 11067416, Time: 1.110 ms
+Hierarchical Sum result: 11067416, Time: 1.406 ms
+  Sum verified, flat/hierarchical: 0.79x
+Flat Stats result: {min -10000, max 10000, sum 11067416, count 4000000, avg 2.767, stddev 5775.017}, Time: 4.337 ms
+Hierarchical Stats result: {min -10000, max 10000, sum 11067416, count 4000000, avg 2.767, stddev 5775.017}, Time: 3.834 ms
+  Stats verified, flat/hierarchical: 1.13x
+------------------------------------------------------------
+
+ */